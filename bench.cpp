@@ -0,0 +1,577 @@
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "kaizen.h"
+#include "bench/baseline.h"
+#include "bench/cases.h"
+#include "bench/scenario.h"
+
+using namespace std;
+
+struct bench_options {
+    bool           list        = false;
+    vector<string> filters;
+    int            repetitions = 5;
+    int            threads     = 1;
+    bool           roofs       = true;
+    string         save_baseline;
+    string         compare_baseline;
+    double         threshold   = 5.0; // percent
+    string         scenario_file;
+    bench::suite_config suite;          // --density, --tensor-shape, --timeline
+    bench::timer_backend timer = bench::active_timer_backend();
+};
+
+bool parse_bench_input(zen::cmd_args &args, bench_options &options) {
+    options.list    = args.is_present("--list");
+    options.roofs   = !args.is_present("--no-roofs");
+    options.filters = args.get_options("--filter");
+
+    if (args.is_present("--filter") && options.filters.empty()) {
+        std::cout << "Error: --filter expects at least one regular expression.";
+        return false;
+    }
+
+    auto reps_options = args.get_options("--reps");
+    if (reps_options.size())
+        options.repetitions = std::atoi(reps_options[0].c_str());
+    if (options.repetitions <= 0) {
+        std::cout << "Error: --reps must be greater than 0.";
+        return false;
+    }
+
+    auto save_options = args.get_options("--save-baseline");
+    auto compare_options = args.get_options("--compare");
+    if ((args.is_present("--save-baseline") && save_options.empty()) ||
+        (args.is_present("--compare") && compare_options.empty())) {
+        std::cout << "Error: --save-baseline and --compare expect a baseline name.";
+        return false;
+    }
+    options.save_baseline    = save_options.size() ? save_options[0] : "";
+    options.compare_baseline = compare_options.size() ? compare_options[0] : "";
+
+    auto scenario_options = args.get_options("--scenario");
+    if (args.is_present("--scenario") && scenario_options.empty()) {
+        std::cout << "Error: --scenario expects a file name.";
+        return false;
+    }
+    options.scenario_file = scenario_options.size() ? scenario_options[0] : "";
+
+    auto density_options = args.get_options("--density");
+    if (args.is_present("--density") && density_options.empty()) {
+        std::cout << "Error: --density expects at least one percentage.";
+        return false;
+    }
+    if (density_options.size())
+        options.suite.densities.clear();
+    for (const auto &d : density_options) {
+        options.suite.densities.push_back(std::atof(d.c_str()));
+        if (options.suite.densities.back() <= 0 || options.suite.densities.back() > 100) {
+            std::cout << "Error: --density must be greater than 0 and at most 100.";
+            return false;
+        }
+    }
+
+    for (const auto &e : args.get_options("--tensor-shape"))
+        options.suite.tensor_shape.push_back(std::atoi(e.c_str()));
+    if (args.is_present("--tensor-shape") &&
+        (options.suite.tensor_shape.size() < 2 || options.suite.tensor_shape.size() > 4 ||
+         *std::min_element(options.suite.tensor_shape.begin(), options.suite.tensor_shape.end()) <= 0)) {
+        std::cout << "Error: --tensor-shape expects 2 to 4 extents greater than 0.";
+        return false;
+    }
+
+    auto timeline_options = args.get_options("--timeline");
+    if (args.is_present("--timeline") && timeline_options.empty()) {
+        std::cout << "Error: --timeline expects a directory.";
+        return false;
+    }
+    options.suite.timeline_dir = timeline_options.size() ? timeline_options[0] : "";
+
+    auto timer_options = args.get_options("--timer");
+    if (args.is_present("--timer") &&
+        (timer_options.empty() || !bench::parse_timer_backend(timer_options[0], options.timer))) {
+        std::cout << "Error: --timer expects clock or tsc.";
+        return false;
+    }
+    if (!bench::set_timer_backend(options.timer)) {
+        std::cout << "Error: --timer tsc needs an invariant time-stamp counter, which this CPU does not report.";
+        return false;
+    }
+
+    auto threshold_options = args.get_options("--threshold");
+    if (threshold_options.size())
+        options.threshold = std::atof(threshold_options[0].c_str());
+    if (options.threshold < 0) {
+        std::cout << "Error: --threshold must not be negative.";
+        return false;
+    }
+
+    auto thread_options = args.get_options("--threads");
+    if (thread_options.size())
+        options.threads = std::atoi(thread_options[0].c_str());
+    if (options.threads <= 0) {
+        std::cout << "Error: --threads must be greater than 0.";
+        return false;
+    }
+    return true;
+}
+
+struct case_outcome {
+    string                           name;
+    bench::stats                     time;
+    size_t                           elements;
+    size_t                           bytes;
+    size_t                           working_set;
+    vector<double>                   samples;
+    vector<pair<string, double>>     counters;
+    vector<string>                   notes;
+};
+
+void print_case_header() {
+    cout << fixed << setprecision(2);
+    cout << "--------------------------------------------------------------------------------------------------------------------------------------" << endl;
+    cout << left << setw(48) << "Case"
+         << right << setw(12) << "Min (us)"
+         << setw(13) << "Median (us)"
+         << setw(12) << "Mean (us)"
+         << setw(13) << "Stddev (us)"
+         << setw(14) << "ns/element"
+         << setw(8) << "GB/s"
+         << setw(6) << "Roof"
+         << setw(8) << "% roof" << endl;
+    cout << "--------------------------------------------------------------------------------------------------------------------------------------" << endl;
+}
+
+void print_case_result(const case_outcome &r, const bench::roofline &roofs) {
+    double ns_per_element = r.elements ? r.time.median * 1000.0 / r.elements : 0;
+    double gb_per_sec = r.time.median ? r.bytes / (r.time.median * 1000.0) : 0;
+    const bench::bandwidth_roof *roof = roofs.matching(r.working_set);
+
+    cout << left << setw(48) << r.name
+         << right << setw(12) << r.time.min
+         << setw(13) << r.time.median
+         << setw(12) << r.time.mean
+         << setw(13) << r.time.stddev
+         << setw(14) << setprecision(3) << ns_per_element << setprecision(2)
+         << setw(8) << gb_per_sec;
+    if (roof && r.bytes)
+        cout << setw(6) << roof->name << setw(7) << setprecision(1) << roofs.percent_of_roof(gb_per_sec, r.working_set)
+             << "%" << setprecision(2);
+    cout << endl;
+
+    for (const auto &[name, value] : r.counters)
+        cout << "    " << left << setw(44) << name << right << setw(12) << value << endl;
+    for (const auto &note : r.notes)
+        cout << "    " << note << endl;
+}
+
+// write/* pays a read for ownership on every line it misses, stream/* does not, so
+// their time ratio is the write-allocate penalty for the same layout and size.
+void print_write_allocate_penalty(const vector<case_outcome> &results) {
+    bool header = false;
+    for (const auto &r : results) {
+        if (r.name.rfind("write/row/", 0) != 0)
+            continue;
+        string shape = r.name.substr(string("write/row/").size());
+        double write_row  = r.time.median;
+        double stream_row = bench::median_of(results, "stream/row/" + shape);
+        double write_col  = bench::median_of(results, "write/column/" + shape);
+        double stream_col = bench::median_of(results, "stream/column/" + shape);
+        if (!stream_row && !stream_col)
+            continue;
+
+        if (!header) {
+            cout << endl << "Write-allocate penalty (plain store time / non-temporal store time):" << endl;
+            cout << "-----------------------------------------------------------------" << endl;
+            cout << left << setw(25) << "Layout/Size"
+                 << right << setw(20) << "Row order (x)"
+                 << setw(20) << "Column order (x)" << endl;
+            cout << "-----------------------------------------------------------------" << endl;
+            header = true;
+        }
+        cout << left << setw(25) << shape
+             << right << setw(20) << (stream_row ? write_row / stream_row : 0)
+             << setw(20) << (stream_col && write_col ? write_col / stream_col : 0) << endl;
+    }
+    if (header)
+        cout << "-----------------------------------------------------------------" << endl;
+}
+
+// read/*/generated/* does the same arithmetic as the stored reads without loading
+// anything, so a stored read's time over it is how far that traversal is memory-bound.
+void print_compute_ceiling(const vector<case_outcome> &results) {
+    auto ratio = [](double stored, double generated) { return stored && generated ? stored / generated : 0; };
+
+    bool header = false;
+    for (const auto &r : results) {
+        const string prefix = "read/row/generated/";
+        if (r.name.rfind(prefix, 0) != 0)
+            continue;
+        string size = r.name.substr(prefix.size());
+        double gen_row = r.time.median;
+        double gen_col = bench::median_of(results, "read/column/generated/" + size);
+
+        if (!header) {
+            cout << endl << "Memory-bound factor (stored read time / generated read time):" << endl;
+            cout << "---------------------------------------------------------------------------------------" << endl;
+            cout << left << setw(15) << "Size"
+                 << right << setw(18) << "Row flat (x)"
+                 << setw(18) << "Column flat (x)"
+                 << setw(18) << "Row jagged (x)"
+                 << setw(18) << "Column jagged (x)" << endl;
+            cout << "---------------------------------------------------------------------------------------" << endl;
+            header = true;
+        }
+        cout << left << setw(15) << size
+             << right << setw(18) << ratio(bench::median_of(results, "read/row/flat/" + size), gen_row)
+             << setw(18) << ratio(bench::median_of(results, "read/column/flat/" + size), gen_col)
+             << setw(18) << ratio(bench::median_of(results, "read/row/jagged/" + size), gen_row)
+             << setw(18) << ratio(bench::median_of(results, "read/column/jagged/" + size), gen_col) << endl;
+    }
+    if (header)
+        cout << "---------------------------------------------------------------------------------------" << endl;
+}
+
+// Raw flat read time over compressed read time for the same size and order: above 1,
+// decompressing during the traversal beats reading the raw layout.
+void print_compression_speedup(const vector<case_outcome> &results) {
+    auto ratio = [&](const string &order, const string &layout, const string &size) {
+        double raw    = bench::median_of(results, "read/" + order + "/flat/" + size);
+        double packed = bench::median_of(results, "read/" + order + "/" + layout + "/" + size);
+        return raw && packed ? raw / packed : 0;
+    };
+
+    bool header = false;
+    for (const auto &r : results) {
+        const string prefix = "read/row/compressed-for/";
+        if (r.name.rfind(prefix, 0) != 0)
+            continue;
+        string size = r.name.substr(prefix.size());
+        if (!bench::median_of(results, "read/row/flat/" + size) && !bench::median_of(results, "read/column/flat/" + size))
+            continue;
+
+        if (!header) {
+            cout << endl << "Compressed vs raw reads (raw flat time / compressed time):" << endl;
+            cout << "---------------------------------------------------------------------------------------" << endl;
+            cout << left << setw(15) << "Size"
+                 << right << setw(18) << "Row FOR (x)"
+                 << setw(18) << "Row delta (x)"
+                 << setw(18) << "Column FOR (x)"
+                 << setw(18) << "Column delta (x)" << endl;
+            cout << "---------------------------------------------------------------------------------------" << endl;
+            header = true;
+        }
+        cout << left << setw(15) << size
+             << right << setw(18) << ratio("row", "compressed-for", size)
+             << setw(18) << ratio("row", "compressed-delta", size)
+             << setw(18) << ratio("column", "compressed-for", size)
+             << setw(18) << ratio("column", "compressed-delta", size) << endl;
+    }
+    if (header)
+        cout << "---------------------------------------------------------------------------------------" << endl;
+}
+
+// ns per nonzero of every sparse format in both orders, one row per size and density,
+// with the fastest format for column order.
+void print_sparse_formats(const vector<case_outcome> &results) {
+    auto ns_per_nonzero = [&](const string &name) {
+        for (const auto &r : results)
+            if (r.name == name)
+                return r.elements ? r.time.median * 1000.0 / r.elements : 0.0;
+        return 0.0;
+    };
+
+    bool header = false;
+    for (const auto &r : results) {
+        const string prefix = "read/row/csr-";
+        if (r.name.rfind(prefix, 0) != 0)
+            continue;
+        string rest = r.name.substr(prefix.size()); // <density>/<size>
+
+        if (!header) {
+            cout << endl << "Sparse formats (ns per nonzero):" << endl;
+            cout << "---------------------------------------------------------------------------------------------------------------" << endl;
+            cout << left << setw(25) << "Density/Size"
+                 << right << setw(10) << "CSR row" << setw(12) << "CSR column"
+                 << setw(10) << "CSC row" << setw(12) << "CSC column"
+                 << setw(10) << "COO row" << setw(12) << "COO column"
+                 << setw(20) << "Best for columns" << endl;
+            cout << "---------------------------------------------------------------------------------------------------------------" << endl;
+            header = true;
+        }
+
+        cout << left << setw(25) << rest << right << setprecision(3);
+        string best;
+        double best_ns = 0;
+        for (const char *format : {"csr", "csc", "coo"}) {
+            double row_ns = ns_per_nonzero(string("read/row/") + format + "-" + rest);
+            double col_ns = ns_per_nonzero(string("read/column/") + format + "-" + rest);
+            cout << setw(10) << row_ns << setw(12) << col_ns;
+            if (col_ns && (best.empty() || col_ns < best_ns)) {
+                best    = format;
+                best_ns = col_ns;
+            }
+        }
+        cout << setw(20) << best << setprecision(2) << endl;
+    }
+    if (header)
+        cout << "---------------------------------------------------------------------------------------------------------------" << endl;
+}
+
+// std-par and std-seq against hand-simd for the same order and size: above 1, the
+// standard algorithm is slower than the hand-written threaded SSE2 kernel.
+void print_std_parallel_overhead(const vector<case_outcome> &results) {
+    bool header = false;
+    for (const auto &r : results) {
+        const string prefix = "hand-simd/";
+        if (r.name.rfind(prefix, 0) != 0)
+            continue;
+        string rest = r.name.substr(prefix.size()); // <order>/flat/<size>
+        double par = bench::median_of(results, "std-par/" + rest), seq = bench::median_of(results, "std-seq/" + rest);
+        if (!par && !seq)
+            continue;
+
+        if (!header) {
+            cout << endl << "Standard parallel algorithms vs hand-written (time / hand-simd time, "
+                 << bench::std_parallel_backend() << " backend):" << endl;
+            cout << "---------------------------------------------------------------------------------------" << endl;
+            cout << left << setw(30) << "Case"
+                 << right << setw(15) << "std-par (x)"
+                 << setw(15) << "std-seq (x)"
+                 << setw(25) << "std-par verdict" << endl;
+            cout << "---------------------------------------------------------------------------------------" << endl;
+            header = true;
+        }
+        double hand = r.time.median;
+        cout << left << setw(30) << rest
+             << right << setw(15) << (par && hand ? par / hand : 0)
+             << setw(15) << (seq && hand ? seq / hand : 0)
+             << setw(25) << (!par ? "-" : par > hand ? "overhead " + to_string(int((par / hand - 1) * 100)) + "%"
+                                                     : "gain " + to_string(int((1 - par / hand) * 100)) + "%")
+             << endl;
+    }
+    if (header)
+        cout << "---------------------------------------------------------------------------------------" << endl;
+}
+
+// Chunk latency percentiles of every latency case, one row per case: a max far above
+// p99.9 is a handful of stalls, not slow steady throughput.
+void print_latency_tails(const vector<case_outcome> &results) {
+    auto counter = [](const case_outcome &r, const string &name) {
+        for (const auto &[key, value] : r.counters)
+            if (key == name)
+                return value;
+        return 0.0;
+    };
+
+    bool header = false;
+    for (const auto &r : results) {
+        if (r.name.rfind("latency", 0) != 0 || !counter(r, "chunks"))
+            continue;
+        if (!header) {
+            cout << endl << "Chunk latency (us per row, column or tile):" << endl;
+            cout << "-----------------------------------------------------------------------------------------------------" << endl;
+            cout << left << setw(42) << "Case"
+                 << right << setw(10) << "p50"
+                 << setw(10) << "p99"
+                 << setw(10) << "p99.9"
+                 << setw(12) << "max"
+                 << setw(14) << "max/p50 (x)" << endl;
+            cout << "-----------------------------------------------------------------------------------------------------" << endl;
+            header = true;
+        }
+        cout << left << setw(42) << r.name
+             << right << setw(10) << counter(r, "chunk p50 (us)")
+             << setw(10) << counter(r, "chunk p99 (us)")
+             << setw(10) << counter(r, "chunk p99.9 (us)")
+             << setw(12) << counter(r, "chunk max (us)")
+             << setw(14) << counter(r, "max/p50 (x)") << endl;
+    }
+    if (header)
+        cout << "-----------------------------------------------------------------------------------------------------" << endl;
+}
+
+// tensor<N>/<order>/<layout>/<shape>: loop orders of each layout and shape from the
+// fastest to the slowest, with their time relative to the fastest.
+void print_tensor_ranking(const vector<case_outcome> &results) {
+    map<string, vector<pair<double, string>>> groups; // "tensorN/<layout>/<shape>" -> (median, order)
+    for (const auto &r : results) {
+        if (r.name.rfind("tensor", 0) != 0)
+            continue;
+        size_t first = r.name.find('/'), second = r.name.find('/', first + 1);
+        string order = r.name.substr(first + 1, second - first - 1);
+        groups[r.name.substr(0, first) + r.name.substr(second)].push_back({r.time.median, order});
+    }
+    if (groups.empty())
+        return;
+
+    cout << endl << "Tensor loop orders, fastest first (axes outermost to innermost, time relative to the fastest):" << endl;
+    cout << "------------------------------------------------------------------------------------------------------" << endl;
+    for (auto &[group, orders] : groups) {
+        sort(orders.begin(), orders.end());
+        cout << group << endl << "   ";
+        for (size_t k = 0; k < orders.size(); k++) {
+            double relative = orders[0].first ? orders[k].first / orders[0].first : 0;
+            cout << " " << orders[k].second << " " << relative << "x";
+            if (k % 8 == 7 && k + 1 < orders.size())
+                cout << endl << "   ";
+        }
+        cout << endl;
+    }
+    cout << "------------------------------------------------------------------------------------------------------" << endl;
+}
+
+// Returns the number of cases that got significantly slower than the baseline.
+int print_baseline_comparison(const vector<bench::baseline_entry> &baseline, const vector<case_outcome> &results,
+                              double threshold) {
+    int slower = 0, faster = 0, threshold_only = 0;
+
+    cout << endl << "Comparison with baseline (threshold " << threshold << "%):" << endl;
+    cout << "------------------------------------------------------------------------------------------------------------------" << endl;
+    cout << left << setw(48) << "Case"
+         << right << setw(16) << "Baseline (us)"
+         << setw(15) << "Current (us)"
+         << setw(12) << "Change (%)"
+         << setw(10) << "p"
+         << setw(17) << "Verdict" << endl;
+    cout << "------------------------------------------------------------------------------------------------------------------" << endl;
+
+    for (const auto &r : results) {
+        auto base = std::find_if(baseline.begin(), baseline.end(),
+                                 [&](const bench::baseline_entry &e) { return e.name == r.name; });
+        if (base == baseline.end()) {
+            cout << left << setw(48) << r.name << right << setw(70) << "not in baseline" << endl;
+            continue;
+        }
+
+        bench::comparison c = bench::compare_case(*base, r.time, r.samples, threshold);
+        slower += c.result == bench::verdict::slower;
+        faster += c.result == bench::verdict::faster;
+        threshold_only += c.threshold_only;
+        string verdict = c.result == bench::verdict::slower ? "SLOWER"
+                       : c.result == bench::verdict::faster ? "faster" : "unchanged";
+        if (c.threshold_only)
+            verdict += " *";
+
+        cout << left << setw(48) << c.name
+             << right << setw(16) << c.baseline_median
+             << setw(15) << c.current_median
+             << setw(12) << c.change_percent;
+        if (c.threshold_only)
+            cout << setw(10) << "n/a";
+        else
+            cout << setw(10) << setprecision(4) << c.p << setprecision(2);
+        cout << setw(17) << verdict << endl;
+    }
+    cout << "------------------------------------------------------------------------------------------------------------------" << endl;
+    cout << slower << " slower, " << faster << " faster" << endl;
+    if (threshold_only)
+        cout << "Warning: " << threshold_only << " case(s) marked * had too few repetitions for the rank test to reach"
+             << " p < 0.05 and were judged on --threshold alone; use --reps 4 or more on both runs." << endl;
+    return slower;
+}
+
+int main(int argc, char **argv) {
+    zen::cmd_args args(argv, argc);
+    bench_options options;
+
+    if (!parse_bench_input(args, options))
+        return 1;
+
+    const bench::cache_topology &topo = bench::host_cache_topology();
+    bench::registry reg;
+    if (options.scenario_file.empty()) {
+        bench::register_default_cases(reg, topo, options.suite);
+    } else {
+        try {
+            std::filesystem::path scenario_path = options.scenario_file;
+            bench::register_scenario_cases(reg, bench::load_scenarios(scenario_path));
+        } catch (const std::exception &e) {
+            std::cout << "Error: scenario " << zen::quote(options.scenario_file) << ": " << e.what();
+            return 1;
+        }
+    }
+
+    vector<const bench::bench_case*> selected;
+    try {
+        selected = reg.match(options.filters);
+    } catch (const std::regex_error &e) {
+        std::cout << "Error: invalid --filter expression: " << e.what();
+        return 1;
+    }
+
+    if (options.list) {
+        for (const auto *c : selected)
+            cout << c->name << endl;
+        return 0;
+    }
+
+    if (selected.empty()) {
+        std::cout << "Error: no case matches the given --filter.";
+        return 1;
+    }
+    for (const auto *c : selected)
+        if (c->on_select)
+            c->on_select();
+
+    // Read the baseline before spending time on the run
+    vector<bench::baseline_entry> baseline;
+    if (!options.compare_baseline.empty()) {
+        try {
+            baseline = bench::load_baseline(options.compare_baseline);
+        } catch (const std::exception &e) {
+            std::cout << "Error: cannot read baseline " << zen::quote(options.compare_baseline) << ": " << e.what();
+            return 1;
+        }
+    }
+
+    vector<case_outcome> results;
+    bench::print_cache_topology(topo);
+    bench::roofline roofs;
+    if (options.roofs) {
+        roofs = bench::measure_roofline(topo);
+        bench::print_roofline(roofs);
+    }
+    cout << "Repetitions: " << options.repetitions << ", threads: " << options.threads
+         << ", timer: " << bench::timer_backend_name(options.timer) << endl;
+    print_case_header();
+    for (const auto *c : selected) {
+        bench::state st(c->repetitions ? c->repetitions : options.repetitions,
+                        c->threads ? c->threads : options.threads);
+        c->body(st);
+        // TSC ticks are reference cycles: the counter's fixed rate, not the core clock
+        if (options.timer == bench::timer_backend::tsc && st.elements() && st.cycle_samples().size())
+            st.add_counter("cycles/element", bench::summarize(st.cycle_samples()).median / double(st.elements()));
+        results.push_back({c->name, bench::summarize(st.samples()), st.elements(), st.bytes(),
+                           st.working_set(), st.samples(), st.counters(), st.notes()});
+        print_case_result(results.back(), roofs);
+    }
+    cout << "--------------------------------------------------------------------------------------------------------------------------------------" << endl;
+
+    print_write_allocate_penalty(results);
+    print_compute_ceiling(results);
+    print_compression_speedup(results);
+    print_sparse_formats(results);
+    print_tensor_ranking(results);
+    print_std_parallel_overhead(results);
+    print_latency_tails(results);
+
+    if (!options.save_baseline.empty()) {
+        vector<bench::baseline_entry> entries;
+        for (const auto &r : results)
+            entries.push_back({r.name, r.time, r.samples});
+        bench::save_baseline(options.save_baseline, entries, zen::timestamp() + ", " + to_string(options.repetitions)
+                             + " repetitions, " + to_string(options.threads) + " threads");
+        cout << endl << "Saved baseline " << zen::quote(options.save_baseline) << " to "
+             << bench::baseline_path(options.save_baseline).string() << endl;
+    }
+
+    if (!options.compare_baseline.empty() && print_baseline_comparison(baseline, results, options.threshold))
+        return 3;
+    return 0;
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../kaizen.h"
+#include "registry.h"
+
+namespace bench {
+
+// Everything a later run needs to decide whether a case got slower: the summary and
+// the raw repetition samples, in microseconds.
+struct baseline_entry {
+    std::string         name;
+    stats               time;
+    std::vector<double> samples;
+};
+
+inline std::filesystem::path baseline_path(const std::string& name) {
+    return std::filesystem::path("baselines") / (name + ".tsv");
+}
+
+// One tab-separated line per case: name, count, min, median, mean, stddev, samples...
+// Lines starting with '#' are comments (when and where the baseline was taken).
+inline void save_baseline(const std::string& name, const std::vector<baseline_entry>& entries,
+                          const std::string& header) {
+    std::filesystem::path path = baseline_path(name);
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path, std::ios::trunc).close(); // zen::file opens existing files only
+
+    zen::file out(path);
+    out << "# " << header << "\n";
+    out << std::setprecision(17);
+    for (const auto& e : entries) {
+        out << e.name << '\t' << e.time.count << '\t' << e.time.min << '\t' << e.time.median
+            << '\t' << e.time.mean << '\t' << e.time.stddev;
+        for (double x : e.samples)
+            out << '\t' << x;
+        out << '\n';
+    }
+}
+
+// Throws std::runtime_error (from zen::file) when the baseline does not exist.
+inline std::vector<baseline_entry> load_baseline(const std::string& name) {
+    std::filesystem::path path = baseline_path(name);
+    zen::file in(path);
+
+    std::vector<baseline_entry> entries;
+    for (const auto& line : in) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream fields(line);
+        baseline_entry e;
+        std::getline(fields, e.name, '\t');
+        fields >> e.time.count >> e.time.min >> e.time.median >> e.time.mean >> e.time.stddev;
+        double x;
+        while (fields >> x)
+            e.samples.push_back(x);
+        if (!e.name.empty())
+            entries.push_back(e);
+    }
+    return entries;
+}
+
+enum class verdict { unchanged, slower, faster };
+
+struct comparison {
+    std::string name;
+    double      baseline_median;
+    double      current_median;
+    double      change_percent; // positive means slower
+    double      z;              // Mann-Whitney z on the repetition samples, positive means slower
+    double      p;              // two-sided p of the rank test, exact for small samples
+    bool        threshold_only; // too few repetitions for the rank test to ever reach alpha
+    verdict     result;
+};
+
+struct rank_test {
+    double z     = 0;
+    double p     = 1;
+    double min_p = 1; // smallest p any ordering of these samples could give
+};
+
+// Mann-Whitney U test of the current samples against the baseline's. z is the normal
+// approximation with the variance corrected for ties, positive when the current samples
+// tend to be larger (slower). Up to 200000 possible splits of the pooled ranks, p is
+// exact: every split is enumerated, ties included, since the normal approximation is
+// too optimistic for a handful of repetitions. Ranks rather than means, so one outlier
+// repetition cannot flip it the way it can flip a t statistic.
+inline rank_test mann_whitney(const std::vector<double>& base, const std::vector<double>& current) {
+    rank_test t;
+    size_t n1 = base.size(), n2 = current.size(), n = n1 + n2;
+    if (n1 < 2 || n2 < 2)
+        return t;
+
+    std::vector<std::pair<double, bool>> pooled; // value, from the current run
+    for (double x : base)
+        pooled.push_back({x, false});
+    for (double x : current)
+        pooled.push_back({x, true});
+    std::sort(pooled.begin(), pooled.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<double> ranks(n);
+    double rank_sum = 0, ties = 0; // ranks of the current samples, sum of t^3 - t over tie groups
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j < n && pooled[j].first == pooled[i].first)
+            j++;
+        double rank = (i + j + 1) / 2.0; // mean of the 1-based ranks i+1 .. j
+        for (size_t k = i; k < j; k++) {
+            ranks[k] = rank;
+            if (pooled[k].second)
+                rank_sum += rank;
+        }
+        double g = double(j - i);
+        ties += g * g * g - g;
+        i = j;
+    }
+
+    double expected = n2 * (n + 1) / 2.0;
+    double variance = n1 * n2 / 12.0 * ((n + 1) - ties / (double(n) * (n - 1)));
+    t.z = variance > 0 ? (rank_sum - expected) / std::sqrt(variance) : 0;
+
+    double splits = 1; // n choose n2
+    for (size_t k = 1; k <= n2; k++)
+        splits = splits * double(n1 + k) / double(k);
+    if (splits > 200000) {
+        t.p     = std::erfc(std::fabs(t.z) / std::sqrt(2.0));
+        t.min_p = 0;
+        return t;
+    }
+
+    // Every way of drawing n2 of the pooled ranks: how many deviate from the expected
+    // rank sum at least as far as the observed split, and how many reach the largest
+    // deviation possible.
+    std::vector<double> deviations;
+    std::vector<char>   drawn(n, 0);
+    std::fill(drawn.begin(), drawn.begin() + n2, 1);
+    do {
+        double sum = 0;
+        for (size_t k = 0; k < n; k++)
+            if (drawn[k])
+                sum += ranks[k];
+        deviations.push_back(std::fabs(sum - expected));
+    } while (std::prev_permutation(drawn.begin(), drawn.end()));
+
+    constexpr double eps = 1e-9; // rank sums are multiples of 0.5
+    double observed = std::fabs(rank_sum - expected);
+    double largest  = *std::max_element(deviations.begin(), deviations.end());
+    size_t as_far = 0, extreme = 0;
+    for (double d : deviations) {
+        as_far  += d >= observed - eps;
+        extreme += d >= largest - eps;
+    }
+    t.p     = double(as_far) / deviations.size();
+    t.min_p = double(extreme) / deviations.size();
+    return t;
+}
+
+// A case counts as slower or faster only when its median moved by more than
+// threshold_percent and the rank test agrees on the direction with p below alpha.
+// With few repetitions the rank test cannot get there at all: with the same --reps on
+// both sides it needs four (exact p = 2/70 at best; three give 2/20). Those cases,
+// and single repetitions, are judged on the threshold alone and flagged so.
+inline comparison compare_case(const baseline_entry& base, const stats& current,
+                               const std::vector<double>& current_samples, double threshold_percent,
+                               double alpha = 0.05) {
+    comparison c;
+    c.name            = base.name;
+    c.baseline_median = base.time.median;
+    c.current_median  = current.median;
+    c.change_percent  = base.time.median ? (current.median / base.time.median - 1.0) * 100.0 : 0;
+
+    rank_test t      = mann_whitney(base.samples, current_samples);
+    c.z              = t.z;
+    c.p              = t.p;
+    c.threshold_only = t.min_p >= alpha;
+
+    bool slower_significant = c.threshold_only || (c.p < alpha && c.z > 0);
+    bool faster_significant = c.threshold_only || (c.p < alpha && c.z < 0);
+    if (c.change_percent > threshold_percent && slower_significant)
+        c.result = verdict::slower;
+    else if (c.change_percent < -threshold_percent && faster_significant)
+        c.result = verdict::faster;
+    else
+        c.result = verdict::unchanged;
+    return c;
+}
+
+} // namespace bench
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+    #define BENCH_HAS_CPUID 1
+#elif defined(_M_X64) || defined(_M_IX86)
+    #include <intrin.h>
+    #define BENCH_HAS_CPUID 1
+#else
+    #define BENCH_HAS_CPUID 0
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <unistd.h>
+#endif
+
+namespace bench {
+
+struct cache_level {
+    int         level     = 0;
+    std::string type;          // Data, Instruction or Unified
+    size_t      size      = 0; // bytes
+    size_t      line_size = 0; // bytes
+    int         ways      = 0; // 0 when fully associative or unknown
+    int         shared_by = 1; // logical CPUs sharing this cache
+};
+
+struct cache_topology {
+    std::vector<cache_level> levels; // ordered by level, instruction caches included
+    size_t                   line_size = 64;
+    std::string              source;  // sysfs, cpuid or defaults
+
+    // Data or unified caches only, innermost first.
+    std::vector<cache_level> data_levels() const {
+        std::vector<cache_level> data;
+        for (const auto& c : levels)
+            if (c.type != "Instruction")
+                data.push_back(c);
+        return data;
+    }
+
+    size_t data_cache_size(int level) const {
+        for (const auto& c : data_levels())
+            if (c.level == level)
+                return c.size;
+        return 0;
+    }
+
+    size_t last_level_size() const {
+        auto data = data_levels();
+        return data.empty() ? 0 : data.back().size;
+    }
+};
+
+namespace internal {
+
+    // "48K", "2048K", "1M" -> bytes
+    inline size_t parse_cache_size(const std::string& text) {
+        size_t value = std::strtoull(text.c_str(), nullptr, 10);
+        if (text.find('K') != std::string::npos) value <<= 10;
+        if (text.find('M') != std::string::npos) value <<= 20;
+        if (text.find('G') != std::string::npos) value <<= 30;
+        return value;
+    }
+
+    // "0-3,8-11" -> 8
+    inline int count_cpu_list(const std::string& text) {
+        int    count = 0;
+        size_t pos   = 0;
+        while (pos < text.size()) {
+            size_t end   = text.find(',', pos);
+            std::string range = text.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+            size_t dash  = range.find('-');
+            if (dash == std::string::npos)
+                count += !range.empty() && range != "\n";
+            else
+                count += std::atoi(range.c_str() + dash + 1) - std::atoi(range.c_str()) + 1;
+            if (end == std::string::npos)
+                break;
+            pos = end + 1;
+        }
+        return std::max(count, 1);
+    }
+
+    inline std::string read_line(const std::filesystem::path& path) {
+        std::ifstream in(path);
+        std::string   line;
+        std::getline(in, line);
+        return line;
+    }
+
+    // /sys/devices/system/cpu/cpu0/cache/index*, one directory per cache seen by cpu0.
+    inline bool detect_from_sysfs(cache_topology& topo) {
+        std::filesystem::path root = "/sys/devices/system/cpu/cpu0/cache";
+        std::error_code ec;
+        if (!std::filesystem::is_directory(root, ec))
+            return false;
+
+        for (const auto& entry : std::filesystem::directory_iterator(root, ec)) {
+            if (entry.path().filename().string().rfind("index", 0) != 0)
+                continue;
+            cache_level c;
+            c.level     = std::atoi(read_line(entry.path() / "level").c_str());
+            c.type      = read_line(entry.path() / "type");
+            c.size      = parse_cache_size(read_line(entry.path() / "size"));
+            c.line_size = std::strtoull(read_line(entry.path() / "coherency_line_size").c_str(), nullptr, 10);
+            c.ways      = std::atoi(read_line(entry.path() / "ways_of_associativity").c_str());
+            c.shared_by = count_cpu_list(read_line(entry.path() / "shared_cpu_list"));
+            if (c.level > 0 && c.size > 0)
+                topo.levels.push_back(c);
+        }
+        return !topo.levels.empty();
+    }
+
+#if BENCH_HAS_CPUID
+    inline bool cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+    #if defined(_MSC_VER)
+        int r[4];
+        __cpuidex(r, int(leaf), int(subleaf));
+        for (int k = 0; k < 4; k++)
+            regs[k] = unsigned(r[k]);
+        return true;
+    #else
+        return __get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]);
+    #endif
+    }
+
+    // Deterministic cache parameters: leaf 4 on Intel, 0x8000001D on AMD, same register layout.
+    inline bool detect_from_cpuid(cache_topology& topo) {
+        unsigned regs[4] = {};
+        unsigned leaf    = 4;
+        if (cpuid(0x80000000u, 0, regs) && regs[0] >= 0x8000001Du) {
+            unsigned vendor[4] = {};
+            cpuid(0, 0, vendor);
+            if (vendor[1] == 0x68747541u) // "Auth"enticAMD
+                leaf = 0x8000001Du;
+        }
+
+        for (unsigned sub = 0; sub < 16; sub++) {
+            if (!cpuid(leaf, sub, regs))
+                return false;
+            unsigned type = regs[0] & 0x1f;
+            if (type == 0)
+                break;
+
+            cache_level c;
+            c.level     = int((regs[0] >> 5) & 0x7);
+            c.type      = type == 1 ? "Data" : type == 2 ? "Instruction" : "Unified";
+            c.shared_by = int(((regs[0] >> 14) & 0xfff) + 1);
+            c.line_size = (regs[1] & 0xfff) + 1;
+            size_t partitions = ((regs[1] >> 12) & 0x3ff) + 1;
+            c.ways      = int(((regs[1] >> 22) & 0x3ff) + 1);
+            size_t sets = size_t(regs[2]) + 1;
+            c.size      = c.ways * partitions * c.line_size * sets;
+            topo.levels.push_back(c);
+        }
+        return !topo.levels.empty();
+    }
+#else
+    inline bool detect_from_cpuid(cache_topology&) { return false; }
+#endif
+
+} // namespace internal
+
+// Reads the cache hierarchy once: sysfs first, CPUID when sysfs is missing (non-Linux
+// hosts, some containers), and a generic 64 B / 32 KiB / 1 MiB / 8 MiB guess otherwise.
+inline const cache_topology& host_cache_topology() {
+    static const cache_topology topo = [] {
+        cache_topology t;
+        if (internal::detect_from_sysfs(t))
+            t.source = "sysfs";
+        else if (internal::detect_from_cpuid(t))
+            t.source = "cpuid";
+        else {
+            t.source = "defaults";
+            t.levels = {
+                {1, "Data",    32 << 10, 64, 8,  1},
+                {2, "Unified", 1 << 20,  64, 16, 1},
+                {3, "Unified", 8 << 20,  64, 16, 1},
+            };
+        }
+        std::sort(t.levels.begin(), t.levels.end(), [](const cache_level& a, const cache_level& b) {
+            return a.level != b.level ? a.level < b.level : a.type < b.type;
+        });
+        for (const auto& c : t.levels)
+            if (c.line_size && c.type != "Instruction") {
+                t.line_size = c.line_size;
+                break;
+            }
+        return t;
+    }();
+    return topo;
+}
+
+inline std::string size_string(size_t bytes) {
+    if (bytes >= (size_t(1) << 20) && bytes % (size_t(1) << 20) == 0) return std::to_string(bytes >> 20) + " MiB";
+    if (bytes >= (size_t(1) << 10)) return std::to_string(bytes >> 10) + " KiB";
+    return std::to_string(bytes) + " B";
+}
+
+inline void print_cache_topology(const cache_topology& topo) {
+    std::cout << "Cache topology (" << topo.source << "), line size " << topo.line_size << " B:" << std::endl;
+    for (const auto& c : topo.levels) {
+        std::cout << "    L" << c.level << " " << std::left << std::setw(12) << c.type
+                  << std::right << std::setw(10) << size_string(c.size)
+                  << std::setw(6) << c.ways << "-way"
+                  << ", shared by " << c.shared_by << " CPU" << (c.shared_by > 1 ? "s" : "") << std::endl;
+    }
+}
+
+// Side of the largest square matrix of T that fills at most `bytes`, rounded down to
+// whole cache lines per row.
+template <typename T>
+int square_side_for(size_t bytes, size_t line_size) {
+    int per_line = int(std::max<size_t>(1, line_size / sizeof(T)));
+    int side     = int(std::sqrt(double(bytes) / sizeof(T)));
+    return std::max(per_line, side / per_line * per_line);
+}
+
+// Two shapes that bracket one cache line: rows x per_line fits exactly in one line per
+// row, rows x (per_line + 1) makes every row straddle two. With 64 B lines and int
+// elements these are the 4x4 and 4x5 matrices main.cpp has always used.
+template <typename T>
+std::pair<std::pair<int, int>, std::pair<int, int>> line_straddle_shapes(const cache_topology& topo) {
+    int per_line = int(std::max<size_t>(1, topo.line_size / sizeof(T)));
+    int rows     = 4;
+    int cols     = std::max(1, per_line / rows);
+    return {{rows, cols}, {rows, cols + 1}};
+}
+
+// Bytes a working set needs to come from DRAM rather than the last-level cache: four
+// times that level, however large it is. The only limit is physical memory, of which it
+// takes at most a quarter. Returns 0 when that limit leaves less than twice the last
+// level, which would mostly be served from the cache; callers skip DRAM then.
+inline size_t dram_working_set(const cache_topology& topo) {
+    size_t llc = topo.last_level_size();
+    size_t ws  = llc ? 4 * llc : size_t(128) << 20;
+#if defined(__unix__) || defined(__APPLE__)
+    long pages = sysconf(_SC_PHYS_PAGES), page = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page > 0)
+        ws = std::min(ws, size_t(pages) * size_t(page) / 4);
+#endif
+    return ws >= 2 * llc ? ws : 0;
+}
+
+// Square int matrices that fill half of each data cache level, plus one of
+// dram_working_set bytes that has to come from DRAM (left out when that is 0).
+inline std::vector<std::pair<int, int>> cache_sweep_sizes(const cache_topology& topo) {
+    std::vector<std::pair<int, int>> sizes;
+    for (const auto& c : topo.data_levels()) {
+        int side = square_side_for<int>(c.size / 2, topo.line_size);
+        if (sizes.empty() || sizes.back().first != side)
+            sizes.push_back({side, side});
+    }
+    size_t dram = dram_working_set(topo);
+    int    side = square_side_for<int>(dram, topo.line_size);
+    if (dram && (sizes.empty() || sizes.back().first < side))
+        sizes.push_back({side, side});
+    return sizes;
+}
+
+// Square tile of T that fills half of the L1 data cache.
+template <typename T>
+int l1_tile_side(const cache_topology& topo) {
+    size_t l1 = topo.data_cache_size(1);
+    return square_side_for<T>(l1 ? l1 / 2 : 16 << 10, topo.line_size);
+}
+
+} // namespace bench
@@ -0,0 +1,927 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "cache_info.h"
+#include "compressed.h"
+#include "false_sharing.h"
+#include "gemm.h"
+#include "kernels.h"
+#include "latency.h"
+#include "matrix.h"
+#include "perf_counters.h"
+#include "records.h"
+#include "roofline.h"
+#include "shared_memory.h"
+#include "sparse.h"
+#include "registry.h"
+#include "std_parallel.h"
+#include "stencil.h"
+#include "stream.h"
+#include "tensor.h"
+#include "thread_timing.h"
+#include "work_stealing.h"
+
+namespace bench {
+
+inline std::string size_name(int row_size, int col_size) {
+    return std::to_string(row_size) + "x" + std::to_string(col_size);
+}
+
+// Small matrices finish in a few nanoseconds, so they are traversed this many
+// times per timed call, as test_aligned_matrix does in main.cpp.
+inline int inner_iterations(int row_size, int col_size) {
+    return size_t(row_size) * col_size < 4096 ? 1000 : 1;
+}
+
+// Per-thread figures of a parallel kernel's last timed call: the slowest thread's busy
+// time over the fastest's, the imbalance, and which thread was slowest, plus one note
+// per thread with its start, end, busy time, bytes and CPU. Nothing for one thread.
+template <typename Timing>
+void add_thread_counters(state& st, const std::vector<Timing>& threads) {
+    if (threads.size() < 2)
+        return;
+    thread_summary s = summarize_threads(threads);
+    st.add_counter("slowest/fastest thread (x)", s.max_min_ratio);
+    st.add_counter("thread imbalance (%)", s.imbalance * 100);
+    st.add_counter("slowest thread", s.slowest);
+    for (size_t t = 0; t < threads.size(); t++) {
+        char line[160];
+        std::snprintf(line, sizeof line, "thread %zu: start %.1f us, end %.1f us, busy %.1f us, %zu bytes, CPU %d", t,
+                      threads[t].start_ns / 1000, threads[t].end_ns / 1000, threads[t].busy_ns / 1000,
+                      threads[t].bytes, threads[t].cpu);
+        st.add_note(line);
+    }
+    st.add_note("slowest: thread " + std::to_string(s.slowest) + " on CPU " + std::to_string(s.cpu) + ", NUMA node "
+                + (s.node < 0 ? std::string("unknown") : std::to_string(s.node)));
+}
+
+// Registers one case that builds a row_size x col_size Matrix and times kernel(m).
+// bytes_per_element is what the kernel has to move for each element it visits.
+template <typename Matrix, typename Kernel>
+void add_matrix_case(registry& reg, const std::string& name, int row_size, int col_size,
+                     size_t bytes_per_element, Kernel kernel) {
+    reg.add(name, [=](state& st) {
+        Matrix m(row_size, col_size);
+        int iterations = inner_iterations(row_size, col_size);
+        st.set_elements(m.size() * iterations);
+        st.set_bytes(m.size() * iterations * bytes_per_element);
+        st.set_working_set(m.size() * sizeof(typename Matrix::value_type));
+        st.measure([&] {
+            if constexpr (std::is_void_v<decltype(kernel(m))>) {
+                for (int k = 0; k < iterations; k++)
+                    kernel(m);
+            } else {
+                decltype(kernel(m)) sum = 0;
+                for (int k = 0; k < iterations; k++)
+                    sum += kernel(m);
+                return sum;
+            }
+        });
+    });
+}
+
+template <typename Matrix>
+void add_read_cases(registry& reg, const std::string& layout, int row_size, int col_size) {
+    using T = typename Matrix::value_type;
+    std::string suffix = "/" + layout + "/" + size_name(row_size, col_size);
+
+    add_matrix_case<Matrix>(reg, "read/row" + suffix, row_size, col_size, sizeof(T),
+                            [](const Matrix& m) { return row_major_sum(m); });
+    add_matrix_case<Matrix>(reg, "read/column" + suffix, row_size, col_size, sizeof(T),
+                            [](const Matrix& m) { return column_major_sum(m); });
+}
+
+// Write-only, read-modify-write and non-temporal store cases. The byte counts are
+// what the program asks for: a plain store of a line that is not cached also costs a
+// read for ownership, which shows up as write/* running slower than stream/*.
+inline void add_write_cases(registry& reg, int row_size, int col_size) {
+    using Matrix = flat_matrix<int>;
+    std::string suffix = "/flat/" + size_name(row_size, col_size);
+
+    add_matrix_case<Matrix>(reg, "write/row" + suffix, row_size, col_size, sizeof(int),
+                            [](Matrix& m) { row_major_write(m); });
+    add_matrix_case<Matrix>(reg, "write/column" + suffix, row_size, col_size, sizeof(int),
+                            [](Matrix& m) { column_major_write(m); });
+    add_matrix_case<Matrix>(reg, "rmw/row" + suffix, row_size, col_size, 2 * sizeof(int),
+                            [](Matrix& m) { row_major_rmw(m); });
+    add_matrix_case<Matrix>(reg, "rmw/column" + suffix, row_size, col_size, 2 * sizeof(int),
+                            [](Matrix& m) { column_major_rmw(m); });
+    add_matrix_case<Matrix>(reg, "stream/row" + suffix, row_size, col_size, sizeof(int),
+                            [](Matrix& m) { row_major_stream(m); });
+    add_matrix_case<Matrix>(reg, "stream/column" + suffix, row_size, col_size, sizeof(int),
+                            [](Matrix& m) { column_major_stream(m); });
+}
+
+// STREAM cases on doubles. They honour --threads; each thread takes a band of rows in
+// row order and a band of columns in column order.
+template <stream_op Op>
+void add_stream_cases(registry& reg, int row_size, int col_size) {
+    std::string suffix = "/flat/" + size_name(row_size, col_size);
+    size_t elements = size_t(row_size) * col_size;
+    size_t bytes    = elements * stream_words_per_element(Op) * sizeof(double);
+    size_t ws       = elements * 3 * sizeof(double);
+
+    reg.add(stream_op_name(Op) + "/row" + suffix, [=](state& st) {
+        stream_arrays<double> s(row_size, col_size);
+        st.set_elements(elements);
+        st.set_bytes(bytes);
+        st.set_working_set(ws);
+        std::vector<thread_timing> timings;
+        st.measure([&] { stream_row_major<Op>(s, st.threads(), &timings); });
+        add_thread_counters(st, timings);
+    });
+    reg.add(stream_op_name(Op) + "/column" + suffix, [=](state& st) {
+        stream_arrays<double> s(row_size, col_size);
+        st.set_elements(elements);
+        st.set_bytes(bytes);
+        st.set_working_set(ws);
+        std::vector<thread_timing> timings;
+        st.measure([&] { stream_column_major<Op>(s, st.threads(), &timings); });
+        add_thread_counters(st, timings);
+    });
+}
+
+// Multithreaded writers partitioned by `p`, with and without cache-line padding. Padded
+// rows are rounded up to a line and get one more line on top, so no two rows ever share
+// a line however col_size falls. Runs on --threads threads, but never fewer than two:
+// one thread cannot share a line.
+inline void add_false_sharing_case(registry& reg, const cache_topology& topo, partition p, bool padded,
+                                   int row_size, int col_size) {
+    std::string name = "false-sharing/" + partition_name(p) + (padded ? "/padded/" : "/packed/")
+                     + size_name(row_size, col_size);
+    constexpr int passes    = 10;
+    size_t        line_size = topo.line_size;
+
+    reg.add(name, [=](state& st) {
+        int threads = std::max(2, st.threads());
+        int line_elements = int(std::max<size_t>(1, line_size / sizeof(int)));
+        flat_matrix<int> m(row_size, col_size,
+                           padded ? line_padded_ld<int>(col_size, line_size) + line_elements : col_size);
+        std::vector<thread_timing> timings;
+        perf_counter l1d = l1d_miss_counter();
+        perf_counter llc = llc_miss_counter();
+
+        st.set_elements(m.size() * passes);
+        st.set_bytes(m.size() * passes * 2 * sizeof(int));
+        st.set_working_set(size_t(m.rows) * m.ld * sizeof(int));
+        l1d.start();
+        llc.start();
+        st.measure([&] { false_sharing_write(m, p, padded, threads, passes, line_size, timings); });
+        l1d.stop();
+        llc.stop();
+
+        for (int t = 0; t < threads; t++)
+            st.add_counter("thread " + std::to_string(t) + " Melem/s",
+                           timings[t].busy_ns ? timings[t].bytes / (2 * sizeof(int)) * 1000.0 / timings[t].busy_ns : 0);
+        add_thread_counters(st, timings);
+
+        double calls = st.repetitions() + 1; // the counters also saw the warm-up call
+        if (l1d.available())
+            st.add_counter(l1d.name() + "/element", l1d.value() / calls / (m.size() * passes));
+        if (llc.available())
+            st.add_counter(llc.name() + "/element", llc.value() / calls / (m.size() * passes));
+        if (!l1d.available() && !llc.available())
+            st.add_note("perf counters unavailable, L1D/LLC misses not measured");
+    });
+}
+
+inline void add_scheduler_counters(state& st, const std::vector<worker_stats>& workers) {
+    size_t steals = 0;
+    for (const auto& w : workers)
+        steals += w.steals;
+    st.add_counter("steals", double(steals));
+    for (size_t t = 0; t < workers.size(); t++)
+        st.add_counter("worker " + std::to_string(t) + " tiles", double(workers[t].tiles));
+    add_thread_counters(st, workers);
+}
+
+// Static row bands against work stealing over square tiles that fill half of L1, in
+// both traversal orders. Counters describe the last timed call.
+inline void add_scheduler_cases(registry& reg, const cache_topology& topo, int row_size, int col_size) {
+    int         tile_size = l1_tile_side<int>(topo);
+    std::string suffix    = "/flat/" + size_name(row_size, col_size);
+
+    for (bool row_order : {true, false}) {
+        std::string order = row_order ? "/row" : "/column";
+
+        reg.add("static-bands" + order + suffix, [=](state& st) {
+            flat_matrix<int> m(row_size, col_size);
+            std::vector<worker_stats> workers;
+            st.set_elements(m.size());
+            st.set_bytes(m.size() * sizeof(int));
+            st.set_working_set(m.size() * sizeof(int));
+            st.measure([&] { return static_row_band_sum(m, st.threads(), row_order, workers); });
+            add_scheduler_counters(st, workers);
+        });
+
+        reg.add("work-stealing" + order + suffix, [=](state& st) {
+            flat_matrix<int> m(row_size, col_size);
+            std::vector<tile> tiles = make_tiles(row_size, col_size, tile_size, tile_size);
+            std::vector<worker_stats> workers;
+            st.set_elements(m.size());
+            st.set_bytes(m.size() * sizeof(int));
+            st.set_working_set(m.size() * sizeof(int));
+            st.measure([&] { return work_stealing_sum(m, tiles, st.threads(), row_order, workers); });
+            add_scheduler_counters(st, workers);
+        });
+    }
+}
+
+// Column traversal of a power-of-two wide matrix for every leading dimension in
+// ld_padding_sweep; the padding label goes into the name as the ld value.
+inline void add_ld_sweep_cases(registry& reg, const cache_topology& topo, int row_size, int col_size) {
+    for (const auto& [label, ld] : ld_padding_sweep<int>(col_size, topo.line_size)) {
+        std::string name = "ld-sweep/column/flat/" + size_name(row_size, col_size) + "/ld" + std::to_string(ld);
+        reg.add(name, [=, label = label, ld = ld](state& st) {
+            flat_matrix<int> m(row_size, col_size, ld);
+            st.set_elements(m.size());
+            st.set_bytes(m.size() * sizeof(int));
+            st.set_working_set(size_t(m.rows) * m.ld * sizeof(int));
+            st.add_note("padding: " + label);
+            st.measure([&] { return column_major_sum(m); });
+        });
+    }
+}
+
+#if BENCH_HAS_SHARED_MEMORY
+// Several processes read one matrix in shared memory at the same time: all in row
+// order, all in column order, or half and half. Comparing the row readers' GB/s between
+// "row" and "mixed" shows what column readers elsewhere cost them. Runs --threads
+// reader processes, at least two. Each repetition is timed from the first reader's
+// start to the last reader's end.
+inline void add_shared_memory_case(registry& reg, const std::string& pattern, int row_size, int col_size) {
+    reg.add("shm/" + pattern + "/flat/" + size_name(row_size, col_size), [=](state& st) {
+        // One result slot per reader in the shared header, so --threads is capped there
+        int readers = std::clamp(st.threads(), 2, int(shared_matrix::max_readers));
+        if (readers < st.threads())
+            st.add_note("readers capped at " + std::to_string(readers) + " (shared_matrix::max_readers)");
+        std::vector<bool> row_order(readers);
+        for (int r = 0; r < readers; r++)
+            row_order[r] = pattern == "row" || (pattern == "mixed" && r % 2 == 0);
+
+        shared_matrix m(row_size, col_size);
+        size_t matrix_bytes = size_t(row_size) * col_size * sizeof(int);
+        st.set_elements(size_t(row_size) * col_size * readers);
+        st.set_bytes(matrix_bytes * readers);
+        st.set_working_set(matrix_bytes);
+
+        std::vector<double> reader_ns(readers, 0.0);
+        std::vector<thread_timing> timings(readers);
+        for (int rep = 0; rep <= st.repetitions(); rep++) { // rep 0 is the warm-up
+            if (!m.run_readers(row_order)) {
+                st.add_note("a reader process failed; results incomplete");
+                return;
+            }
+            double first = m.result(0).start_ns, last = m.result(0).end_ns;
+            for (int r = 0; r < readers; r++) {
+                first = std::min(first, m.result(r).start_ns);
+                last  = std::max(last, m.result(r).end_ns);
+                if (rep > 0)
+                    reader_ns[r] += m.result(r).end_ns - m.result(r).start_ns;
+            }
+            if (rep > 0)
+                st.record((last - first) / 1000.0);
+            for (int r = 0; r < readers; r++)
+                timings[r] = {m.result(r).start_ns - first, m.result(r).end_ns - first,
+                              m.result(r).end_ns - m.result(r).start_ns, matrix_bytes, m.result(r).cpu};
+        }
+        add_thread_counters(st, timings);
+
+        double row_gbs = 0, col_gbs = 0;
+        int    row_readers = 0;
+        for (int r = 0; r < readers; r++) {
+            double gbs = matrix_bytes * st.repetitions() / reader_ns[r];
+            st.add_counter("reader " + std::to_string(r) + (row_order[r] ? " (row) GB/s" : " (column) GB/s"), gbs);
+            (row_order[r] ? row_gbs : col_gbs) += gbs;
+            row_readers += row_order[r];
+        }
+        if (row_readers)
+            st.add_counter("mean row reader GB/s", row_gbs / row_readers);
+        if (readers - row_readers)
+            st.add_counter("mean column reader GB/s", col_gbs / (readers - row_readers));
+    });
+}
+#endif
+
+// The cache-line straddle pair (4x4 and 4x5 with 64 B lines), one square size per cache
+// level and one from DRAM, plus the rectangular 2000x4000 README case.
+inline std::vector<std::pair<int, int>> default_sizes(const cache_topology& topo) {
+    auto [fits, straddles] = line_straddle_shapes<int>(topo);
+    std::vector<std::pair<int, int>> sizes = {fits, straddles};
+    for (auto size : cache_sweep_sizes(topo))
+        sizes.push_back(size);
+    sizes.push_back({2000, 4000});
+    return sizes;
+}
+
+inline void register_read_cases(registry& reg, const cache_topology& topo) {
+    for (auto [row_size, col_size] : default_sizes(topo)) {
+        add_read_cases<flat_matrix<int>>(reg, "flat", row_size, col_size);
+        add_read_cases<jagged_matrix<int>>(reg, "jagged", row_size, col_size);
+    }
+}
+
+// read/*/generated/* walk a generated_matrix that computes i + j instead of loading
+// it: the same kernels with no memory traffic, a compute-only ceiling for the flat and
+// jagged cases of the same size. No bytes are counted, so they report no GB/s.
+inline void register_generated_cases(registry& reg, const cache_topology& topo) {
+    using Matrix = generated_matrix<int>;
+    for (auto [row_size, col_size] : default_sizes(topo)) {
+        std::string suffix = "/generated/" + size_name(row_size, col_size);
+        add_matrix_case<Matrix>(reg, "read/row" + suffix, row_size, col_size, 0,
+                                [](const Matrix& m) { return row_major_sum(m); });
+        add_matrix_case<Matrix>(reg, "read/column" + suffix, row_size, col_size, 0,
+                                [](const Matrix& m) { return column_major_sum(m); });
+    }
+}
+
+// read/*/compressed-for/* and read/*/compressed-delta/* decode sensor-like data
+// (sensor_sample) during the traversal. Bytes are the compressed bytes actually read;
+// the ns/element column is the effective element throughput against read/*/flat/*.
+inline void add_compressed_cases(registry& reg, compression kind, int row_size, int col_size) {
+    std::string suffix = std::string("/") + compression_name(kind) + "/" + size_name(row_size, col_size);
+    for (bool row_order : {true, false})
+        reg.add(std::string("read/") + (row_order ? "row" : "column") + suffix, [=](state& st) {
+            generated_matrix<int, sensor_sample<int>> source(row_size, col_size);
+            compressed_matrix m(source, kind);
+            if ((row_order ? compressed_row_sum(m) : compressed_column_sum(m)) != row_major_sum(source))
+                st.add_note("decoded sum does not match the source matrix");
+
+            size_t raw_bytes = m.size() * sizeof(int);
+            st.set_elements(m.size());
+            st.set_bytes(m.compressed_bytes());
+            st.set_working_set(m.compressed_bytes());
+            st.measure([&] { return row_order ? compressed_row_sum(m) : compressed_column_sum(m); });
+            st.add_counter("compression ratio", double(raw_bytes) / m.compressed_bytes());
+            st.add_counter("bits per element", m.compressed_bytes() * 8.0 / m.size());
+            double median_us = summarize(st.samples()).median;
+            if (median_us)
+                st.add_counter("raw-equivalent GB/s", raw_bytes / (median_us * 1000.0));
+        });
+}
+
+inline void register_compressed_cases(registry& reg, const cache_topology& topo) {
+    for (auto [row_size, col_size] : default_sizes(topo)) {
+        if (col_size < compressed_block)
+            continue;
+        add_compressed_cases(reg, compression::frame_of_reference, row_size, col_size);
+        add_compressed_cases(reg, compression::delta, row_size, col_size);
+    }
+}
+
+// "1pct", "0.1pct"
+inline std::string density_name(double percent) {
+    std::ostringstream out;
+    out << percent << "pct";
+    return out.str();
+}
+
+// read/<order>/<csr|csc|coo>-<density>/RxC over nonzeros of i + j drawn at the given
+// density. Elements are nonzeros, so ns/element is the time per nonzero.
+template <typename Sparse, typename Convert>
+void add_sparse_cases(registry& reg, const std::string& format, double percent, int row_size, int col_size,
+                      Convert convert) {
+    std::string suffix = "/" + format + "-" + density_name(percent) + "/" + size_name(row_size, col_size);
+    for (bool row_order : {true, false})
+        reg.add(std::string("read/") + (row_order ? "row" : "column") + suffix, [=](state& st) {
+            Sparse m = convert(sparsify(generated_matrix<int>(row_size, col_size), percent / 100.0));
+            st.set_elements(m.nonzeros());
+            st.set_bytes(traversal_bytes(m, row_order));
+            st.set_working_set(storage_bytes(m));
+            st.measure([&] { return row_order ? row_major_sum(m) : column_major_sum(m); });
+            st.add_counter("nonzeros", double(m.nonzeros()));
+            st.add_counter("bytes per nonzero", m.nonzeros() ? double(storage_bytes(m)) / m.nonzeros() : 0);
+        });
+}
+
+// Sizes of at least 4096 elements, so the lowest density still leaves some nonzeros.
+inline void register_sparse_cases(registry& reg, const cache_topology& topo, const std::vector<double>& densities) {
+    for (auto [row_size, col_size] : default_sizes(topo)) {
+        if (size_t(row_size) * col_size < 4096)
+            continue;
+        for (double percent : densities) {
+            add_sparse_cases<csr_matrix>(reg, "csr", percent, row_size, col_size, to_csr);
+            add_sparse_cases<csc_matrix>(reg, "csc", percent, row_size, col_size, to_csc);
+            add_sparse_cases<coo_matrix>(reg, "coo", percent, row_size, col_size, [](coo_matrix s) { return s; });
+        }
+    }
+}
+
+// fields-<1|4|all>/<order>/<aos|soa|aosoa>/RxC read one, half or all of the eight
+// fields of every record. GB/s counts only the fields read; the counters give the
+// useful and wasted bytes of every cache line the traversal has to touch.
+template <typename Layout>
+void add_record_cases(registry& reg, const cache_topology& topo, int row_size, int col_size) {
+    for (int fields : {1, record_fields / 2, record_fields}) {
+        std::string prefix = "fields-" + (fields == record_fields ? std::string("all") : std::to_string(fields));
+        std::string suffix = std::string("/") + Layout::name + "/" + size_name(row_size, col_size);
+        for (bool row_order : {true, false})
+            reg.add(prefix + (row_order ? "/row" : "/column") + suffix, [=, &topo](state& st) {
+                Layout m(row_size, col_size);
+                size_t useful = m.size() * fields * sizeof(int);
+                st.set_elements(m.size());
+                st.set_bytes(useful);
+                st.set_working_set(m.size() * sizeof(record));
+                st.measure([&] { return row_order ? row_major_fields_sum(m, fields) : column_major_fields_sum(m, fields); });
+
+                size_t lines = touched_lines(m, fields, topo.line_size);
+                double used  = lines ? double(useful) / lines : 0;
+                st.add_counter("lines touched", double(lines));
+                st.add_counter("useful bytes per line", used);
+                st.add_counter("wasted bytes per line", topo.line_size - used);
+            });
+    }
+}
+
+// Squares of records filling half of each data cache level. Records are eight times
+// the size of an int, so the last level already takes longer than the int DRAM case.
+inline void register_record_cases(registry& reg, const cache_topology& topo) {
+    std::vector<int> sides;
+    for (const auto& c : topo.data_levels())
+        sides.push_back(square_side_for<record>(c.size / 2, topo.line_size));
+    sides.erase(std::unique(sides.begin(), sides.end()), sides.end());
+    for (int side : sides) {
+        add_record_cases<aos_matrix>(reg, topo, side, side);
+        add_record_cases<soa_matrix>(reg, topo, side, side);
+        add_record_cases<aosoa_matrix>(reg, topo, side, side);
+    }
+}
+
+// gemm-<int|float>/<variant>/jagged/NxN: C = A * B with one of the six loop orders,
+// cache-blocked, or packed. Elements are multiply-adds; GFLOP/s counts two operations
+// for each. Every variant is checked once against ijk before it is timed.
+template <typename T>
+void add_gemm_cases(registry& reg, const cache_topology& topo, const std::string& type, int n) {
+    using Matrix = jagged_matrix<T>;
+    using Kernel = std::function<void(const Matrix&, const Matrix&, Matrix&)>;
+    int           block = square_side_for<T>(topo.data_cache_size(1) ? topo.data_cache_size(1) / 3 : 8 << 10, topo.line_size);
+    gemm_blocking blk   = gemm_blocking_for<T>(topo);
+
+    std::vector<std::pair<std::string, Kernel>> variants = {
+        {"ijk", gemm_ijk<T>}, {"ikj", gemm_ikj<T>}, {"jik", gemm_jik<T>},
+        {"jki", gemm_jki<T>}, {"kij", gemm_kij<T>}, {"kji", gemm_kji<T>},
+        {"blocked", [block](const Matrix& a, const Matrix& b, Matrix& c) { gemm_blocked(a, b, c, block); }},
+        {"packed",  [blk](const Matrix& a, const Matrix& b, Matrix& c) { gemm_packed(a, b, c, blk); }},
+    };
+    for (const auto& [variant, kernel] : variants)
+        reg.add("gemm-" + type + "/" + variant + "/jagged/" + size_name(n, n), [=](state& st) {
+            Matrix a(n, n), b(n, n), c(n, n), reference(n, n);
+            gemm_ijk(a, b, reference);
+            kernel(a, b, c);
+            double expected = matrix_checksum(reference), got = matrix_checksum(c);
+            if (std::abs(got - expected) > 1e-4 * std::abs(expected))
+                st.add_note("result differs from ijk");
+
+            st.set_elements(size_t(n) * n * n);
+            st.set_working_set(3 * size_t(n) * n * sizeof(T));
+            st.measure([&] { kernel(a, b, c); });
+            double median_us = summarize(st.samples()).median;
+            if (median_us)
+                st.add_counter("GFLOP/s", 2.0 * n * n * n / (median_us * 1000.0));
+            if (variant == "blocked")
+                st.add_counter("block", block);
+            if (variant == "packed") {
+                st.add_counter("mc", blk.mc);
+                st.add_counter("kc", blk.kc);
+            }
+        });
+}
+
+// One size whose three matrices fit in half of L1 and one in half of L2, at most 384:
+// GEMM is cubic and the plain loop orders are slow.
+inline void register_gemm_cases(registry& reg, const cache_topology& topo) {
+    std::vector<int> sides;
+    for (int level : {1, 2}) {
+        size_t bytes = topo.data_cache_size(level);
+        if (bytes)
+            sides.push_back(std::min(384, square_side_for<int>(bytes / 2 / 3, topo.line_size)));
+    }
+    sides.erase(std::unique(sides.begin(), sides.end()), sides.end());
+    for (int n : sides) {
+        add_gemm_cases<int>(reg, topo, "int", n);
+        add_gemm_cases<float>(reg, topo, "float", n);
+    }
+}
+
+// <stencil5|stencil9>/<row|column|tiled|temporal>/flat/RxC on floats. Elements are
+// cell updates, so ns/element is per update; bytes are one read and one write of
+// every interior cell per call, which the temporal variant makes only once for
+// stencil_temporal_steps updates.
+constexpr int stencil_temporal_steps = 4;
+
+template <stencil_shape S>
+void add_stencil_cases(registry& reg, const cache_topology& topo, int row_size, int col_size) {
+    std::string prefix = std::string(stencil_name(S)) + "/";
+    std::string suffix = "/flat/" + size_name(row_size, col_size);
+    size_t      cells  = size_t(row_size - 2) * (col_size - 2);
+    size_t      l1     = topo.data_cache_size(1) ? topo.data_cache_size(1) : 32 << 10;
+    size_t      l2     = topo.data_cache_size(2) ? topo.data_cache_size(2) : 1 << 20;
+    int         tile   = square_side_for<float>(l1 / 4, topo.line_size);
+    // Two band buffers of band + 2 * steps rows in half of L2
+    int         band   = std::max(8, int(l2 / 2 / (2 * sizeof(float) * col_size)) - 2 * stencil_temporal_steps);
+
+    auto add = [&](const std::string& variant, int steps, auto kernel) {
+        reg.add(prefix + variant + suffix, [=](state& st) {
+            flat_matrix<float> in(row_size, col_size), out(row_size, col_size);
+            st.set_elements(cells * steps);
+            st.set_bytes(cells * 2 * sizeof(float));
+            st.set_working_set(2 * in.size() * sizeof(float));
+            st.measure([&] { kernel(in, out); });
+
+            flat_matrix<float> ref_in(row_size, col_size), reference(row_size, col_size);
+            stencil_steps<S>(ref_in, reference, steps);
+            for (int i = 0; i < row_size; i++)
+                if (!std::equal(&out.at(i, 0), &out.at(i, 0) + col_size, &reference.at(i, 0))) {
+                    st.add_note("result differs from " + std::to_string(steps) + " row-order sweep(s)");
+                    break;
+                }
+            double median_us = summarize(st.samples()).median;
+            if (median_us)
+                st.add_counter("Mcells/s", cells * steps / median_us);
+            if (variant == "tiled")
+                st.add_counter("tile", tile);
+            if (variant == "temporal") {
+                st.add_counter("band rows", band);
+                st.add_counter("steps per pass", steps);
+            }
+        });
+    };
+    add("row", 1, [](const flat_matrix<float>& in, flat_matrix<float>& out) { stencil_row_major<S>(in, out); });
+    add("column", 1, [](const flat_matrix<float>& in, flat_matrix<float>& out) { stencil_column_major<S>(in, out); });
+    add("tiled", 1, [tile](const flat_matrix<float>& in, flat_matrix<float>& out) { stencil_tiled<S>(in, out, tile); });
+    add("temporal", stencil_temporal_steps, [band](const flat_matrix<float>& in, flat_matrix<float>& out) {
+        stencil_temporal<S>(in, out, stencil_temporal_steps, band);
+    });
+}
+
+// Squares filling half of L1 and of L2, and the 2000x4000 README case, which is past
+// L2 on most hosts. Larger sizes make the column and multi-step cases too slow to run
+// with the rest of the suite.
+inline void register_stencil_cases(registry& reg, const cache_topology& topo) {
+    std::vector<std::pair<int, int>> sizes;
+    for (int level : {1, 2})
+        if (size_t bytes = topo.data_cache_size(level)) {
+            int side = square_side_for<float>(bytes / 2, topo.line_size);
+            sizes.push_back({side, side});
+        }
+    sizes.push_back({2000, 4000});
+    for (auto [row_size, col_size] : sizes) {
+        add_stencil_cases<stencil_shape::five_point>(reg, topo, row_size, col_size);
+        add_stencil_cases<stencil_shape::nine_point>(reg, topo, row_size, col_size);
+    }
+}
+
+inline std::string shape_name(const std::vector<int>& extents) {
+    std::string name;
+    for (int e : extents)
+        name += (name.empty() ? "" : "x") + std::to_string(e);
+    return name;
+}
+
+// tensor<N>/<loop order>/<right|left|stride>/<shape> for every loop order over the N
+// axes. The stride layout stores the last two axes swapped, its contiguous runs padded
+// to whole cache lines.
+template <size_t N>
+void add_tensor_cases(registry& reg, const cache_topology& topo, const std::array<int, N>& extents) {
+    using Tensor = tensor<int, N>;
+    std::array<int, N> storage_order;
+    std::iota(storage_order.begin(), storage_order.end(), 0);
+    if (N > 1)
+        std::swap(storage_order[N - 2], storage_order[N - 1]);
+
+    std::vector<std::pair<std::string, std::array<size_t, N>>> layouts = {
+        {"right",  layout_right(extents)},
+        {"left",   layout_left(extents)},
+        {"stride", layout_stride<int>(extents, storage_order, topo.line_size)},
+    };
+    std::string shape = shape_name(std::vector<int>(extents.begin(), extents.end()));
+    for (const auto& [layout, strides] : layouts)
+        for (const auto& order : loop_orders<N>())
+            reg.add("tensor" + std::to_string(N) + "/" + loop_order_name(order) + "/" + layout + "/" + shape,
+                    [=](state& st) {
+                        Tensor t(extents, strides);
+                        st.set_elements(t.size());
+                        st.set_bytes(t.size() * sizeof(int));
+                        st.set_working_set(t.span * sizeof(int));
+                        st.measure([&] { return tensor_sum(t, order); });
+                    });
+}
+
+// Registers the tensor cases for a shape of 2 to 4 extents; false for any other rank.
+inline bool add_tensor_cases(registry& reg, const cache_topology& topo, const std::vector<int>& shape) {
+    auto fixed = [&]<size_t N>(std::integral_constant<size_t, N>) {
+        std::array<int, N> extents;
+        std::copy(shape.begin(), shape.end(), extents.begin());
+        add_tensor_cases<N>(reg, topo, extents);
+    };
+    switch (shape.size()) {
+        case 2: fixed(std::integral_constant<size_t, 2>{}); return true;
+        case 3: fixed(std::integral_constant<size_t, 3>{}); return true;
+        case 4: fixed(std::integral_constant<size_t, 4>{}); return true;
+        default: return false;
+    }
+}
+
+// Without --tensor-shape: a 3D a x 2a x 4a and a 4D a x a x 2a x 4a tensor of about four
+// times the last-level cache, so the axes differ in length. Capped at 8 MiB: there are
+// 30 loop orders per layout, and the worst of them are far slower than the best.
+inline void register_tensor_cases(registry& reg, const cache_topology& topo, const std::vector<int>& shape) {
+    if (!shape.empty()) {
+        add_tensor_cases(reg, topo, shape);
+        return;
+    }
+    double elements = double(std::min<size_t>(4 * topo.last_level_size(), size_t(8) << 20)) / sizeof(int);
+    int a3 = std::max(1, int(std::cbrt(elements / 8)));
+    int a4 = std::max(1, int(std::pow(elements / 8, 0.25)));
+    add_tensor_cases<3>(reg, topo, {a3, 2 * a3, 4 * a3});
+    add_tensor_cases<4>(reg, topo, {a4, a4, 2 * a4, 4 * a4});
+}
+
+// Row and column reductions through std::transform_reduce under par_unseq and seq,
+// next to hand-written SSE2 kernels spread over --threads threads with parallel_for.
+// par_unseq picks its own thread count; the note names the backend it ran on.
+inline void add_std_parallel_cases(registry& reg, int row_size, int col_size) {
+    using Matrix = flat_matrix<int>;
+    std::string suffix = "/flat/" + size_name(row_size, col_size);
+
+    auto add = [&](const std::string& name, auto kernel) {
+        reg.add(name + suffix, [=](state& st) {
+            Matrix m(row_size, col_size);
+            std::vector<int> rows = index_range(row_size), cols = index_range(col_size);
+            st.set_elements(m.size());
+            st.set_bytes(m.size() * sizeof(int));
+            st.set_working_set(m.size() * sizeof(int));
+            st.add_note(std::string("std::execution backend: ") + std_parallel_backend());
+            st.measure([&] { return kernel(m, rows, cols); });
+        });
+    };
+    add("std-par/row", [](const Matrix& m, const auto& rows, const auto&) { return std_par_row_sum(m, rows); });
+    add("std-par/column", [](const Matrix& m, const auto&, const auto& cols) { return std_par_column_sum(m, cols); });
+    add("std-seq/row", [](const Matrix& m, const auto& rows, const auto&) { return std_seq_row_sum(m, rows); });
+    add("std-seq/column", [](const Matrix& m, const auto&, const auto& cols) { return std_seq_column_sum(m, cols); });
+
+    for (bool row_order : {true, false})
+        reg.add(std::string(row_order ? "hand-simd/row" : "hand-simd/column") + suffix, [=](state& st) {
+            Matrix m(row_size, col_size);
+            std::vector<thread_timing> timings;
+            st.set_elements(m.size());
+            st.set_bytes(m.size() * sizeof(int));
+            st.set_working_set(m.size() * sizeof(int));
+            st.measure([&] {
+                return row_order ? threaded_simd_row_sum(m, st.threads(), &timings)
+                                 : threaded_simd_column_sum(m, st.threads(), &timings);
+            });
+            add_thread_counters(st, timings);
+        });
+}
+
+// Chunk latency percentiles in microseconds, and with a timeline directory, the last
+// timed call's chunks as <dir>/<case name with / as _>.csv.
+inline void add_latency_counters(state& st, const std::string& name, const latency_histogram& hist,
+                                 const std::vector<chunk_sample>& timeline, const std::string& timeline_dir) {
+    double us = ns_per_tick() / 1000;
+    double p50 = hist.percentile(0.5) * us;
+    st.add_counter("chunks", double(hist.count()));
+    st.add_counter("chunk p50 (us)", p50);
+    st.add_counter("chunk p99 (us)", hist.percentile(0.99) * us);
+    st.add_counter("chunk p99.9 (us)", hist.percentile(0.999) * us);
+    st.add_counter("chunk max (us)", hist.max() * us);
+    st.add_counter("max/p50 (x)", p50 ? hist.max() * us / p50 : 0);
+    if (timeline_dir.empty())
+        return;
+
+    std::string file = name;
+    std::replace(file.begin(), file.end(), '/', '_');
+    std::filesystem::path path = std::filesystem::path(timeline_dir) / (file + ".csv");
+    std::error_code ec;
+    std::filesystem::create_directories(timeline_dir, ec);
+    std::ofstream out(path);
+    if (!out) {
+        st.add_note("could not write timeline " + path.string());
+        return;
+    }
+    out << "chunk,start_us,duration_us\n";
+    for (size_t c = 0; c < timeline.size(); c++)
+        out << c << ',' << timeline[c].start * us << ',' << timeline[c].ticks * us << '\n';
+    st.add_note("timeline: " + path.string());
+}
+
+// Every row, column or tile timed on its own with cycle_count(), into a log-linear
+// histogram. latency/* reads a matrix that is already resident, so its tail is
+// interrupts and other jitter; latency-first-touch/* writes freshly allocated memory
+// on every call, so page faults (and THP work) land in the tail too.
+inline void add_latency_cases(registry& reg, const cache_topology& topo, int row_size, int col_size,
+                              const std::string& timeline_dir) {
+    int         tile   = l1_tile_side<int>(topo);
+    std::string suffix = "/flat/" + size_name(row_size, col_size);
+    size_t      bytes  = size_t(row_size) * col_size * sizeof(int);
+
+    for (chunk_order order : {chunk_order::row, chunk_order::column, chunk_order::tiled}) {
+        std::string name = std::string("latency/") + chunk_order_name(order) + suffix;
+        reg.add(name, [=](state& st) {
+            flat_matrix<int> m(row_size, col_size);
+            latency_histogram hist;
+            std::vector<chunk_sample> timeline;
+            int calls = 0;
+            st.set_elements(m.size());
+            st.set_bytes(bytes);
+            st.set_working_set(bytes);
+            st.measure([&] {
+                if (calls++ == 1) // drop what the warm-up call recorded
+                    hist.clear();
+                timeline.clear();
+                size_t sum = 0;
+                timed_chunks(row_size, col_size, order, tile, [&](int i, int j) { sum += m.at(i, j); }, hist,
+                             timeline_dir.empty() ? nullptr : &timeline);
+                return sum;
+            });
+            add_latency_counters(st, name, hist, timeline, timeline_dir);
+        });
+
+        name = std::string("latency-first-touch/") + chunk_order_name(order) + suffix;
+        reg.add(name, [=](state& st) {
+            latency_histogram hist;
+            std::vector<chunk_sample> timeline;
+            st.set_elements(size_t(row_size) * col_size);
+            st.set_bytes(bytes);
+            st.set_working_set(bytes);
+            for (int rep = 0; rep < st.repetitions(); rep++) {
+                int* data = static_cast<int*>(allocate_aligned(bytes)); // not touched yet
+                timeline.clear();
+                bench::timer timer;
+                timer.start();
+                timed_chunks(row_size, col_size, order, tile,
+                             [&](int i, int j) { data[size_t(i) * col_size + j] = i + j; }, hist,
+                             timeline_dir.empty() ? nullptr : &timeline);
+                timer.stop();
+                st.record(timer);
+                free_aligned(data);
+            }
+            add_latency_counters(st, name, hist, timeline, timeline_dir);
+        });
+    }
+}
+
+// read and write in both orders through md::mdspan, as read/<order>/md-<layout>/RxC
+// and write/<order>/md-<layout>/RxC. md-right should match the flat cases exactly;
+// the other layouts only change the mapping the kernels are instantiated with.
+template <class Layout>
+void add_mdspan_cases(registry& reg, const std::string& layout, int row_size, int col_size) {
+    using Matrix = md_matrix<int, Layout>;
+    std::string suffix = "/md-" + layout + "/" + size_name(row_size, col_size);
+
+    add_matrix_case<Matrix>(reg, "read/row" + suffix, row_size, col_size, sizeof(int),
+                            [](const Matrix& m) { return row_major_sum(m.view()); });
+    add_matrix_case<Matrix>(reg, "read/column" + suffix, row_size, col_size, sizeof(int),
+                            [](const Matrix& m) { return column_major_sum(m.view()); });
+    add_matrix_case<Matrix>(reg, "write/row" + suffix, row_size, col_size, sizeof(int),
+                            [](Matrix& m) { row_major_write(m.view()); });
+    add_matrix_case<Matrix>(reg, "write/column" + suffix, row_size, col_size, sizeof(int),
+                            [](Matrix& m) { column_major_write(m.view()); });
+}
+
+// The straddle pair, halves of L1 and L2 and the 2000x4000 README case. Morton rounds
+// both extents up to powers of two, which makes the DRAM-sized square too large.
+inline void register_mdspan_cases(registry& reg, const cache_topology& topo) {
+    auto [fits, straddles] = line_straddle_shapes<int>(topo);
+    std::vector<std::pair<int, int>> sizes = {fits, straddles};
+    for (int level : {1, 2})
+        if (size_t bytes = topo.data_cache_size(level)) {
+            int side = square_side_for<int>(bytes / 2, topo.line_size);
+            sizes.push_back({side, side});
+        }
+    sizes.push_back({2000, 4000});
+    for (auto [row_size, col_size] : sizes) {
+        add_mdspan_cases<md::layout_right>(reg, "right", row_size, col_size);
+        add_mdspan_cases<md::layout_left>(reg, "left", row_size, col_size);
+        add_mdspan_cases<layout_padded<>>(reg, "padded", row_size, col_size);
+        add_mdspan_cases<layout_tiled<>>(reg, "tiled", row_size, col_size);
+        add_mdspan_cases<layout_morton>(reg, "morton", row_size, col_size);
+    }
+}
+
+// A square in L1, where dispatch overhead dominates, one filling half of L2, and the
+// README's 2000x4000 from DRAM.
+inline void register_std_parallel_cases(registry& reg, const cache_topology& topo) {
+    std::vector<std::pair<int, int>> sizes;
+    for (int level : {1, 2})
+        if (size_t bytes = topo.data_cache_size(level)) {
+            int side = square_side_for<int>(bytes / 2, topo.line_size);
+            sizes.push_back({side, side});
+        }
+    sizes.push_back({2000, 4000});
+    for (auto [row_size, col_size] : sizes)
+        add_std_parallel_cases(reg, row_size, col_size);
+}
+
+// Half of L2, where only interrupts should stand out, and the README's 2000x4000.
+inline void register_latency_cases(registry& reg, const cache_topology& topo, const std::string& timeline_dir) {
+    std::vector<std::pair<int, int>> sizes;
+    if (size_t bytes = topo.data_cache_size(2)) {
+        int side = square_side_for<int>(bytes / 2, topo.line_size);
+        sizes.push_back({side, side});
+    }
+    sizes.push_back({2000, 4000});
+    for (auto [row_size, col_size] : sizes)
+        add_latency_cases(reg, topo, row_size, col_size, timeline_dir);
+}
+
+inline void register_write_cases(registry& reg, const cache_topology& topo) {
+    for (auto [row_size, col_size] : default_sizes(topo))
+        add_write_cases(reg, row_size, col_size);
+}
+
+// STREAM wants the arrays together to be four times the last-level cache; capped at
+// 256 MiB for the three of them.
+inline void register_stream_cases(registry& reg, const cache_topology& topo) {
+    size_t total = std::min<size_t>(4 * topo.last_level_size(), size_t(256) << 20);
+    int    side  = square_side_for<double>(total / 3, topo.line_size);
+    for (auto [row_size, col_size] : {std::pair{side, side}, std::pair{2000, 4000}}) {
+        add_stream_cases<stream_op::copy>(reg, row_size, col_size);
+        add_stream_cases<stream_op::scale>(reg, row_size, col_size);
+        add_stream_cases<stream_op::add>(reg, row_size, col_size);
+        add_stream_cases<stream_op::triad>(reg, row_size, col_size);
+    }
+}
+
+// Sizes kept in L1 and L2 so line ping-pong, not DRAM, is what the padding changes. The
+// side is one element short of a whole number of lines, so packed rows straddle lines
+// and row bands share a line at every edge.
+inline void register_false_sharing_cases(registry& reg, const cache_topology& topo) {
+    for (int level : {1, 2}) {
+        size_t bytes = topo.data_cache_size(level);
+        if (!bytes)
+            continue;
+        int side = square_side_for<int>(bytes / 2, topo.line_size) - 1;
+        for (partition p : {partition::interleaved, partition::column_bands, partition::row_bands})
+            for (bool padded : {false, true})
+                add_false_sharing_case(reg, topo, p, padded, side, side);
+    }
+}
+
+// Square, the README's short-wide case, its transpose and two extreme aspect ratios.
+inline void register_scheduler_cases(registry& reg, const cache_topology& topo) {
+    for (auto [row_size, col_size] : {std::pair{2048, 2048}, std::pair{2000, 4000}, std::pair{4000, 2000},
+                                      std::pair{64, 65536},  std::pair{65536, 64}})
+        add_scheduler_cases(reg, topo, row_size, col_size);
+}
+
+inline void register_ld_sweep_cases(registry& reg, const cache_topology& topo) {
+    add_ld_sweep_cases(reg, topo, 1024, 4096);
+    add_ld_sweep_cases(reg, topo, 512, 8192);
+}
+
+// One matrix that stays in the last-level cache and one that has to come from DRAM.
+inline void register_shared_memory_cases(registry& reg, const cache_topology& topo) {
+#if BENCH_HAS_SHARED_MEMORY
+    auto sizes = cache_sweep_sizes(topo);
+    std::vector<std::pair<int, int>> shapes = {sizes.back()};
+    if (sizes.size() > 1)
+        shapes.insert(shapes.begin(), sizes[sizes.size() - 2]);
+    for (auto [row_size, col_size] : shapes)
+        for (const char* pattern : {"row", "column", "mixed"})
+            add_shared_memory_case(reg, pattern, row_size, col_size);
+#else
+    (void)reg;
+    (void)topo;
+#endif
+}
+
+// Suite settings that come from the command line.
+struct suite_config {
+    std::vector<double> densities = {1.0}; // sparse cases, percent of nonzeros (--density)
+    std::vector<int>    tensor_shape;      // tensor cases, 2 to 4 extents (--tensor-shape)
+    std::string         timeline_dir;      // latency cases dump their chunks here (--timeline)
+};
+
+inline void register_default_cases(registry& reg, const cache_topology& topo, const suite_config& config = {}) {
+    register_read_cases(reg, topo);
+    register_generated_cases(reg, topo);
+    register_compressed_cases(reg, topo);
+    register_sparse_cases(reg, topo, config.densities);
+    register_record_cases(reg, topo);
+    register_gemm_cases(reg, topo);
+    register_stencil_cases(reg, topo);
+    register_tensor_cases(reg, topo, config.tensor_shape);
+    register_mdspan_cases(reg, topo);
+    register_std_parallel_cases(reg, topo);
+    register_latency_cases(reg, topo, config.timeline_dir);
+    register_write_cases(reg, topo);
+    register_stream_cases(reg, topo);
+    register_false_sharing_cases(reg, topo);
+    register_scheduler_cases(reg, topo);
+    register_ld_sweep_cases(reg, topo);
+    register_shared_memory_cases(reg, topo);
+}
+
+} // namespace bench
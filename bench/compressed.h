@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define BENCH_HAS_SSE2 1
+#else
+    #define BENCH_HAS_SSE2 0
+#endif
+
+namespace bench {
+
+enum class compression { frame_of_reference, delta };
+
+inline const char* compression_name(compression c) {
+    return c == compression::delta ? "compressed-delta" : "compressed-for";
+}
+
+// Rows are cut into blocks of 64 elements, each packed with its own bit width. The
+// 16 values of each of the 4 lanes are packed one after another, with one word of each
+// lane stored side by side. That way one SSE2 shift and mask decodes four values.
+constexpr int compressed_block = 64;
+constexpr int compressed_lanes = 4;
+
+struct compressed_header {
+    int32_t  base;      // frame of reference: block minimum; delta: first value minus min_delta
+    int32_t  min_delta; // delta only: smallest difference between neighbours
+    uint32_t offset;    // first word of the block in words
+    uint32_t bits;      // 0..32 per packed value
+};
+
+namespace internal {
+
+    inline uint32_t bits_for(uint32_t range) {
+        uint32_t bits = 0;
+        while (bits < 32 && (range >> bits))
+            bits++;
+        return bits;
+    }
+
+    inline void pack_block(const uint32_t* values, uint32_t bits, std::vector<uint32_t>& words) {
+        constexpr int per_lane = compressed_block / compressed_lanes;
+        size_t first = words.size();
+        words.resize(first + size_t(per_lane * bits + 31) / 32 * compressed_lanes, 0);
+        for (int k = 0; k < compressed_block && bits; k++) {
+            int      lane  = k % compressed_lanes;
+            uint32_t bit   = uint32_t(k / compressed_lanes) * bits;
+            uint32_t word  = bit / 32, shift = bit % 32;
+            words[first + word * compressed_lanes + lane] |= values[k] << shift;
+            if (shift + bits > 32)
+                words[first + (word + 1) * compressed_lanes + lane] |= values[k] >> (32 - shift);
+        }
+    }
+
+    // Inverse of pack_block: 64 values in their original order.
+    inline void unpack_block(const uint32_t* in, uint32_t bits, uint32_t* out) {
+        constexpr int per_lane = compressed_block / compressed_lanes;
+        if (bits == 0) {
+            std::fill(out, out + compressed_block, 0u);
+            return;
+        }
+        uint32_t mask = bits == 32 ? ~0u : (1u << bits) - 1;
+#if BENCH_HAS_SSE2
+        __m128i vmask = _mm_set1_epi32(int(mask));
+        for (int p = 0; p < per_lane; p++) {
+            uint32_t bit  = uint32_t(p) * bits;
+            uint32_t word = bit / 32, shift = bit % 32;
+            __m128i  v    = _mm_srl_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + word * compressed_lanes)),
+                                          _mm_cvtsi32_si128(int(shift)));
+            if (shift + bits > 32)
+                v = _mm_or_si128(v, _mm_sll_epi32(
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + (word + 1) * compressed_lanes)),
+                        _mm_cvtsi32_si128(int(32 - shift))));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + p * compressed_lanes), _mm_and_si128(v, vmask));
+        }
+#else
+        for (int p = 0; p < per_lane; p++) {
+            uint32_t bit  = uint32_t(p) * bits;
+            uint32_t word = bit / 32, shift = bit % 32;
+            for (int lane = 0; lane < compressed_lanes; lane++) {
+                uint32_t v = in[word * compressed_lanes + lane] >> shift;
+                if (shift + bits > 32)
+                    v |= in[(word + 1) * compressed_lanes + lane] << (32 - shift);
+                out[p * compressed_lanes + lane] = v & mask;
+            }
+        }
+#endif
+    }
+
+    // out[k] += base for frame of reference.
+    inline void add_base(uint32_t* out, uint32_t base) {
+#if BENCH_HAS_SSE2
+        __m128i vbase = _mm_set1_epi32(int(base));
+        for (int k = 0; k < compressed_block; k += compressed_lanes) {
+            __m128i* p = reinterpret_cast<__m128i*>(out + k);
+            _mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), vbase));
+        }
+#else
+        for (int k = 0; k < compressed_block; k++)
+            out[k] += base;
+#endif
+    }
+
+    // out[k] = base + sum of (out[m] + min_delta) for m <= k, four lanes at a time.
+    inline void prefix_sum(uint32_t* out, uint32_t base, uint32_t min_delta) {
+#if BENCH_HAS_SSE2
+        __m128i carry = _mm_set1_epi32(int(base));
+        __m128i vmin  = _mm_set1_epi32(int(min_delta));
+        for (int k = 0; k < compressed_block; k += compressed_lanes) {
+            __m128i* p = reinterpret_cast<__m128i*>(out + k);
+            __m128i  v = _mm_add_epi32(_mm_loadu_si128(p), vmin);
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, carry);
+            _mm_storeu_si128(p, v);
+            carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+#else
+        uint32_t running = base;
+        for (int k = 0; k < compressed_block; k++)
+            out[k] = running += out[k] + min_delta;
+#endif
+    }
+
+} // namespace internal
+
+// Read-only int matrix stored as packed 64-element row blocks, either as offsets from
+// the block minimum (frame of reference) or as differences between neighbours, offset
+// by the smallest one (delta). All arithmetic wraps modulo 2^32, so every int block
+// round-trips exactly; a block whose values spread over the full range just takes 32
+// bits per value.
+class compressed_matrix {
+public:
+    using value_type = int;
+
+    int rows;
+    int cols;
+
+    template <typename Matrix>
+    compressed_matrix(const Matrix& m, compression kind)
+        : rows(m.rows), cols(m.cols), kind_(kind), blocks_per_row_((m.cols + compressed_block - 1) / compressed_block) {
+        headers_.reserve(size_t(rows) * blocks_per_row_);
+        uint32_t values[compressed_block];
+        for (int i = 0; i < rows; i++)
+            for (int b = 0; b < blocks_per_row_; b++) {
+                // The last block of a row is padded by repeating its final value
+                int first = b * compressed_block, count = block_count(b);
+                for (int k = 0; k < compressed_block; k++)
+                    values[k] = uint32_t(m.at(i, first + std::min(k, count - 1)));
+                headers_.push_back(encode(values));
+            }
+        words_.shrink_to_fit();
+    }
+
+    // Number of real elements in block b of a row.
+    int block_count(int b) const { return std::min(compressed_block, cols - b * compressed_block); }
+    int blocks_per_row() const { return blocks_per_row_; }
+
+    // The 64 values of block b of row i, padding included.
+    void decode(int i, int b, int* out) const {
+        const compressed_header& h = headers_[size_t(i) * blocks_per_row_ + b];
+        uint32_t* u = reinterpret_cast<uint32_t*>(out);
+        internal::unpack_block(words_.data() + h.offset, h.bits, u);
+        if (kind_ == compression::delta)
+            internal::prefix_sum(u, uint32_t(h.base), uint32_t(h.min_delta));
+        else
+            internal::add_base(u, uint32_t(h.base));
+    }
+
+    size_t size() const { return size_t(rows) * cols; }
+    // Packed words plus block headers.
+    size_t compressed_bytes() const { return words_.size() * sizeof(uint32_t) + headers_.size() * sizeof(compressed_header); }
+
+private:
+    compressed_header encode(uint32_t* values) {
+        compressed_header h{};
+        h.offset = uint32_t(words_.size());
+        if (kind_ == compression::frame_of_reference) {
+            int32_t lo = int32_t(values[0]), hi = lo;
+            for (int k = 1; k < compressed_block; k++) {
+                lo = std::min(lo, int32_t(values[k]));
+                hi = std::max(hi, int32_t(values[k]));
+            }
+            h.base = lo;
+            h.bits = internal::bits_for(uint32_t(hi) - uint32_t(lo));
+            for (int k = 0; k < compressed_block; k++)
+                values[k] -= uint32_t(lo);
+        } else {
+            int64_t deltas[compressed_block];
+            int64_t lo = INT64_MAX, hi = INT64_MIN;
+            for (int k = 1; k < compressed_block; k++) {
+                deltas[k] = int64_t(int32_t(values[k])) - int32_t(values[k - 1]);
+                lo = std::min(lo, deltas[k]);
+                hi = std::max(hi, deltas[k]);
+            }
+            // The first element counts as one smallest step up from base
+            deltas[0]   = lo;
+            h.min_delta = int32_t(lo);
+            h.base      = int32_t(values[0] - uint32_t(lo));
+            h.bits      = hi - lo > int64_t(UINT32_MAX) ? 32 : internal::bits_for(uint32_t(hi - lo));
+            for (int k = 0; k < compressed_block; k++)
+                values[k] = uint32_t(deltas[k] - lo);
+        }
+        internal::pack_block(values, h.bits, words_);
+        return h;
+    }
+
+    compression                    kind_;
+    int                            blocks_per_row_;
+    std::vector<compressed_header> headers_;
+    std::vector<uint32_t>          words_;
+};
+
+// Decodes each block into a small buffer and sums it, row by row.
+inline size_t compressed_row_sum(const compressed_matrix& m) {
+    alignas(16) int block[compressed_block];
+    size_t sum = 0;
+    for (int i = 0; i < m.rows; i++)
+        for (int b = 0; b < m.blocks_per_row(); b++) {
+            m.decode(i, b, block);
+            for (int k = 0, n = m.block_count(b); k < n; k++)
+                sum += block[k];
+        }
+    return sum;
+}
+
+// A single element cannot be decoded on its own, so column order decodes a band of
+// 64 rows of one block column into a 16 KiB tile, walks that tile column by column,
+// and moves down to the next band.
+inline size_t compressed_column_sum(const compressed_matrix& m) {
+    std::vector<int> tile(size_t(compressed_block) * compressed_block);
+    size_t sum = 0;
+    for (int b = 0; b < m.blocks_per_row(); b++) {
+        int n = m.block_count(b);
+        for (int band = 0; band < m.rows; band += compressed_block) {
+            int band_rows = std::min(compressed_block, m.rows - band);
+            for (int r = 0; r < band_rows; r++)
+                m.decode(band + r, b, tile.data() + size_t(r) * compressed_block);
+            for (int j = 0; j < n; j++)
+                for (int r = 0; r < band_rows; r++)
+                    sum += tile[size_t(r) * compressed_block + j];
+        }
+    }
+    return sum;
+}
+
+// A smooth signal plus up to 15 counts of deterministic noise: compresses like a
+// sensor trace, unlike i + j, which delta-encodes to nothing.
+template <typename T = int>
+struct sensor_sample {
+    T operator()(int i, int j) const {
+        uint32_t h = uint32_t(i) * 2654435761u ^ uint32_t(j) * 40503u;
+        return T(i + j + int((h >> 13) & 15));
+    }
+};
+
+} // namespace bench
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "matrix.h"
+#include "thread_timing.h"
+
+namespace bench {
+
+// How the columns (or rows) of a row-major matrix are split between writer threads.
+//   interleaved:  thread t owns columns t, t + T, t + 2T, ... so neighbours share every line
+//   column-bands: thread t owns one contiguous band of columns, neighbours share the band edges
+//   row-bands:    thread t owns a band of whole rows, neighbours share at most the row edges
+// Padded variants give every thread whole cache lines: the leading dimension is rounded
+// up to a line, column bands are cut on line boundaries and interleaving is done a line
+// of columns at a time.
+enum class partition { interleaved, column_bands, row_bands };
+
+inline std::string partition_name(partition p) {
+    switch (p) {
+        case partition::interleaved:  return "interleaved";
+        case partition::column_bands: return "column-bands";
+        case partition::row_bands:    return "row-bands";
+    }
+    return "";
+}
+
+struct thread_share {
+    int first_row = 0, last_row = 0;
+    int first_col = 0, last_col = 0;
+    int col_step  = 1; // columns are taken col_block at a time, col_step columns apart
+    int col_block = 1;
+};
+
+inline thread_share partition_share(partition p, bool padded, int t, int threads,
+                                    int row_size, int col_size, int line_elements) {
+    thread_share s;
+    s.first_row = 0;
+    s.last_row  = row_size;
+    s.first_col = 0;
+    s.last_col  = col_size;
+
+    int unit = padded ? line_elements : 1;
+    switch (p) {
+        case partition::interleaved:
+            s.first_col = t * unit;
+            s.col_block = unit;
+            s.col_step  = threads * unit;
+            break;
+        case partition::column_bands: {
+            int units   = (col_size + unit - 1) / unit;
+            s.first_col = std::min(col_size, int(static_cast<long long>(units) * t / threads) * unit);
+            s.last_col  = std::min(col_size, int(static_cast<long long>(units) * (t + 1) / threads) * unit);
+            break;
+        }
+        case partition::row_bands:
+            s.first_row = int(static_cast<long long>(row_size) * t / threads);
+            s.last_row  = int(static_cast<long long>(row_size) * (t + 1) / threads);
+            break;
+    }
+    return s;
+}
+
+// Every thread increments each of its elements `passes` times, walking its share row by
+// row, so threads with adjacent columns store into the same lines at the same time.
+// timings[t] describes thread t's share of the call; each increment reads and writes
+// one int.
+inline void false_sharing_write(flat_matrix<int>& m, partition p, bool padded, int threads, int passes,
+                                size_t line_size, std::vector<thread_timing>& timings) {
+    int line_elements = int(std::max<size_t>(1, line_size / sizeof(int)));
+    auto origin = thread_clock::now();
+    timings.assign(threads, {});
+    auto work = [&](int t) {
+        thread_share s = partition_share(p, padded, t, threads, m.rows, m.cols, line_elements);
+        size_t written = 0;
+        auto start = thread_clock::now();
+        for (int pass = 0; pass < passes; pass++) {
+            for (int i = s.first_row; i < s.last_row; i++) {
+                for (int j0 = s.first_col; j0 < s.last_col; j0 += s.col_step) {
+                    int j1 = std::min(j0 + s.col_block, s.last_col);
+                    for (int j = j0; j < j1; j++)
+                        m.at(i, j) += 1;
+                    written += j1 - j0;
+                }
+            }
+        }
+        record_thread(timings[t], origin, start, written * 2 * sizeof(int));
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++)
+        workers.emplace_back(work, t);
+    work(0);
+    for (auto& w : workers)
+        w.join();
+}
+
+} // namespace bench
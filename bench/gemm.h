@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "cache_info.h"
+#include "matrix.h"
+
+namespace bench {
+
+// C = A * B on square jagged matrices, the layout initialize_matrix builds. Every
+// variant zeroes C first, so each timed call does the same 2 * n^3 operations.
+
+template <typename T>
+void zero_matrix(jagged_matrix<T>& c) {
+    for (int i = 0; i < c.rows; i++)
+        std::fill(c.data[i], c.data[i] + c.cols, T(0));
+}
+
+// The six loop orders. The innermost loop decides the access pattern: ijk walks a
+// column of B, ikj and kij walk rows of B and C, jki and kji walk columns of A and C.
+
+template <typename T>
+void gemm_ijk(const jagged_matrix<T>& a, const jagged_matrix<T>& b, jagged_matrix<T>& c) {
+    zero_matrix(c);
+    for (int i = 0; i < a.rows; i++)
+        for (int j = 0; j < b.cols; j++)
+            for (int k = 0; k < a.cols; k++)
+                c.data[i][j] += a.data[i][k] * b.data[k][j];
+}
+
+template <typename T>
+void gemm_ikj(const jagged_matrix<T>& a, const jagged_matrix<T>& b, jagged_matrix<T>& c) {
+    zero_matrix(c);
+    for (int i = 0; i < a.rows; i++)
+        for (int k = 0; k < a.cols; k++)
+            for (int j = 0; j < b.cols; j++)
+                c.data[i][j] += a.data[i][k] * b.data[k][j];
+}
+
+template <typename T>
+void gemm_jik(const jagged_matrix<T>& a, const jagged_matrix<T>& b, jagged_matrix<T>& c) {
+    zero_matrix(c);
+    for (int j = 0; j < b.cols; j++)
+        for (int i = 0; i < a.rows; i++)
+            for (int k = 0; k < a.cols; k++)
+                c.data[i][j] += a.data[i][k] * b.data[k][j];
+}
+
+template <typename T>
+void gemm_jki(const jagged_matrix<T>& a, const jagged_matrix<T>& b, jagged_matrix<T>& c) {
+    zero_matrix(c);
+    for (int j = 0; j < b.cols; j++)
+        for (int k = 0; k < a.cols; k++)
+            for (int i = 0; i < a.rows; i++)
+                c.data[i][j] += a.data[i][k] * b.data[k][j];
+}
+
+template <typename T>
+void gemm_kij(const jagged_matrix<T>& a, const jagged_matrix<T>& b, jagged_matrix<T>& c) {
+    zero_matrix(c);
+    for (int k = 0; k < a.cols; k++)
+        for (int i = 0; i < a.rows; i++)
+            for (int j = 0; j < b.cols; j++)
+                c.data[i][j] += a.data[i][k] * b.data[k][j];
+}
+
+template <typename T>
+void gemm_kji(const jagged_matrix<T>& a, const jagged_matrix<T>& b, jagged_matrix<T>& c) {
+    zero_matrix(c);
+    for (int k = 0; k < a.cols; k++)
+        for (int j = 0; j < b.cols; j++)
+            for (int i = 0; i < a.rows; i++)
+                c.data[i][j] += a.data[i][k] * b.data[k][j];
+}
+
+// ikj over square tiles of `block` elements, so the tiles of A, B and C being combined
+// stay in cache together.
+template <typename T>
+void gemm_blocked(const jagged_matrix<T>& a, const jagged_matrix<T>& b, jagged_matrix<T>& c, int block) {
+    zero_matrix(c);
+    for (int ii = 0; ii < a.rows; ii += block)
+        for (int kk = 0; kk < a.cols; kk += block)
+            for (int jj = 0; jj < b.cols; jj += block) {
+                int i_end = std::min(ii + block, a.rows);
+                int k_end = std::min(kk + block, a.cols);
+                int j_end = std::min(jj + block, b.cols);
+                for (int i = ii; i < i_end; i++)
+                    for (int k = kk; k < k_end; k++) {
+                        T a_ik = a.data[i][k];
+                        for (int j = jj; j < j_end; j++)
+                            c.data[i][j] += a_ik * b.data[k][j];
+                    }
+            }
+}
+
+// Register tile of the packed micro-kernel and the panel sizes around it.
+constexpr int gemm_mr = 4;
+constexpr int gemm_nr = 4;
+
+struct gemm_blocking {
+    int mc; // rows of A packed at once, sized for L2
+    int kc; // depth of one packed panel, sized so a B panel sits in L1
+};
+
+// kc * gemm_nr elements of B fill half of L1; mc * kc elements of A fill half of L2.
+template <typename T>
+gemm_blocking gemm_blocking_for(const cache_topology& topo) {
+    size_t l1 = topo.data_cache_size(1) ? topo.data_cache_size(1) : 32 << 10;
+    size_t l2 = topo.data_cache_size(2) ? topo.data_cache_size(2) : 1 << 20;
+    int    kc = int(std::clamp<size_t>(l1 / 2 / (gemm_nr * sizeof(T)), 16, 512));
+    int    mc = int(std::clamp<size_t>(l2 / 2 / (kc * sizeof(T)), gemm_mr, 1024)) / gemm_mr * gemm_mr;
+    return {mc, kc};
+}
+
+namespace internal {
+
+    // C[row..row + rows, col..col + cols] += packed A panel x packed B panel, with the
+    // gemm_mr x gemm_nr partial sums held in registers for the whole depth.
+    template <typename T>
+    void gemm_micro_kernel(int depth, const T* a_panel, const T* b_panel, jagged_matrix<T>& c,
+                           int row, int col, int rows, int cols) {
+        T acc[gemm_mr][gemm_nr] = {};
+        for (int p = 0; p < depth; p++)
+            for (int i = 0; i < gemm_mr; i++)
+                for (int j = 0; j < gemm_nr; j++)
+                    acc[i][j] += a_panel[p * gemm_mr + i] * b_panel[p * gemm_nr + j];
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                c.data[row + i][col + j] += acc[i][j];
+    }
+
+} // namespace internal
+
+// Goto-style GEMM: a kc-deep slice of B is copied into contiguous gemm_nr-wide column
+// panels, an mc x kc block of A into gemm_mr-tall row panels, and the micro-kernel
+// streams through both with unit stride. Edges are zero-padded in the packed copies.
+template <typename T>
+void gemm_packed(const jagged_matrix<T>& a, const jagged_matrix<T>& b, jagged_matrix<T>& c, gemm_blocking blk) {
+    zero_matrix(c);
+    int m = a.rows, n = b.cols, k = a.cols;
+    int n_panels = (n + gemm_nr - 1) / gemm_nr;
+    std::vector<T> b_pack(size_t(n_panels) * gemm_nr * blk.kc);
+    std::vector<T> a_pack(size_t(blk.mc) * blk.kc);
+
+    for (int pc = 0; pc < k; pc += blk.kc) {
+        int kb = std::min(blk.kc, k - pc);
+        for (int jr = 0; jr < n; jr += gemm_nr) {
+            T* panel = b_pack.data() + size_t(jr / gemm_nr) * kb * gemm_nr;
+            for (int p = 0; p < kb; p++)
+                for (int j = 0; j < gemm_nr; j++)
+                    panel[p * gemm_nr + j] = jr + j < n ? b.data[pc + p][jr + j] : T(0);
+        }
+
+        for (int ic = 0; ic < m; ic += blk.mc) {
+            int mb = std::min(blk.mc, m - ic);
+            for (int ir = 0; ir < mb; ir += gemm_mr) {
+                T* panel = a_pack.data() + size_t(ir / gemm_mr) * kb * gemm_mr;
+                for (int p = 0; p < kb; p++)
+                    for (int i = 0; i < gemm_mr; i++)
+                        panel[p * gemm_mr + i] = ir + i < mb ? a.data[ic + ir + i][pc + p] : T(0);
+            }
+
+            for (int jr = 0; jr < n; jr += gemm_nr)
+                for (int ir = 0; ir < mb; ir += gemm_mr)
+                    internal::gemm_micro_kernel(kb, a_pack.data() + size_t(ir / gemm_mr) * kb * gemm_mr,
+                                                b_pack.data() + size_t(jr / gemm_nr) * kb * gemm_nr, c,
+                                                ic + ir, jr, std::min(gemm_mr, mb - ir), std::min(gemm_nr, n - jr));
+        }
+    }
+}
+
+// Sum of every element of C, to check the variants against each other.
+template <typename T>
+double matrix_checksum(const jagged_matrix<T>& c) {
+    double sum = 0;
+    for (int i = 0; i < c.rows; i++)
+        for (int j = 0; j < c.cols; j++)
+            sum += double(c.data[i][j]);
+    return sum;
+}
+
+} // namespace bench
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "matrix.h"
+#include "mdspan.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <immintrin.h>
+    #define BENCH_HAS_STREAM_STORES 1
+#else
+    #define BENCH_HAS_STREAM_STORES 0
+#endif
+
+namespace bench {
+
+// Integers are summed into size_t, floating point into double.
+template <typename T>
+using accumulator_t = std::conditional_t<std::is_floating_point_v<T>, double, size_t>;
+
+// Reduction kernels shared by every matrix layout. They return the sum instead of
+// writing it to a volatile local, so the loop body stays a plain load and add.
+
+template <typename Matrix>
+auto row_major_sum(const Matrix& m) {
+    accumulator_t<typename Matrix::value_type> sum = 0;
+    for (int i = 0; i < m.rows; i++)
+        for (int j = 0; j < m.cols; j++)
+            sum += m.at(i, j);
+    return sum;
+}
+
+template <typename Matrix>
+auto column_major_sum(const Matrix& m) {
+    accumulator_t<typename Matrix::value_type> sum = 0;
+    for (int j = 0; j < m.cols; j++)
+        for (int i = 0; i < m.rows; i++)
+            sum += m.at(i, j);
+    return sum;
+}
+
+// The same kernels over a rank-2 md::mdspan. The layout is a template parameter, so
+// m[i, j] compiles to that layout's index arithmetic with nothing in between, and one
+// kernel source serves layout_right, layout_left and every custom layout policy.
+
+template <class T, class Extents, class Layout, class Accessor>
+    requires(Extents::rank() == 2)
+auto row_major_sum(md::mdspan<T, Extents, Layout, Accessor> m) {
+    accumulator_t<std::remove_cv_t<T>> sum = 0;
+    for (size_t i = 0; i < size_t(m.extent(0)); i++)
+        for (size_t j = 0; j < size_t(m.extent(1)); j++)
+            sum += m[i, j];
+    return sum;
+}
+
+template <class T, class Extents, class Layout, class Accessor>
+    requires(Extents::rank() == 2)
+auto column_major_sum(md::mdspan<T, Extents, Layout, Accessor> m) {
+    accumulator_t<std::remove_cv_t<T>> sum = 0;
+    for (size_t j = 0; j < size_t(m.extent(1)); j++)
+        for (size_t i = 0; i < size_t(m.extent(0)); i++)
+            sum += m[i, j];
+    return sum;
+}
+
+template <class T, class Extents, class Layout, class Accessor>
+    requires(Extents::rank() == 2)
+void row_major_write(md::mdspan<T, Extents, Layout, Accessor> m) {
+    for (size_t i = 0; i < size_t(m.extent(0)); i++)
+        for (size_t j = 0; j < size_t(m.extent(1)); j++)
+            m[i, j] = T(i + j);
+}
+
+template <class T, class Extents, class Layout, class Accessor>
+    requires(Extents::rank() == 2)
+void column_major_write(md::mdspan<T, Extents, Layout, Accessor> m) {
+    for (size_t j = 0; j < size_t(m.extent(1)); j++)
+        for (size_t i = 0; i < size_t(m.extent(0)); i++)
+            m[i, j] = T(i + j);
+}
+
+// Store kernels. Every element gets i + j, the value initialize_matrix uses, so a
+// row-order store loop cannot be collapsed into a memset.
+
+template <typename Matrix>
+void row_major_write(Matrix& m) {
+    for (int i = 0; i < m.rows; i++)
+        for (int j = 0; j < m.cols; j++)
+            m.at(i, j) = i + j;
+}
+
+template <typename Matrix>
+void column_major_write(Matrix& m) {
+    for (int j = 0; j < m.cols; j++)
+        for (int i = 0; i < m.rows; i++)
+            m.at(i, j) = i + j;
+}
+
+template <typename Matrix>
+void row_major_rmw(Matrix& m) {
+    for (int i = 0; i < m.rows; i++)
+        for (int j = 0; j < m.cols; j++)
+            m.at(i, j) += 1;
+}
+
+template <typename Matrix>
+void column_major_rmw(Matrix& m) {
+    for (int j = 0; j < m.cols; j++)
+        for (int i = 0; i < m.rows; i++)
+            m.at(i, j) += 1;
+}
+
+// Non-temporal stores bypass the cache, so the line is never read for ownership.
+// Row order streams whole vectors once a row reaches vector alignment; column order
+// can only stream one element at a time. Without SSE2 these fall back to plain stores.
+
+inline void row_major_stream(flat_matrix<int>& m) {
+#if BENCH_HAS_STREAM_STORES
+    #ifdef __AVX__
+        constexpr int lanes = 8;
+    #else
+        constexpr int lanes = 4;
+    #endif
+    for (int i = 0; i < m.rows; i++) {
+        int* row = &m.at(i, 0);
+        int  j   = 0;
+        while (j < m.cols && reinterpret_cast<uintptr_t>(row + j) % (lanes * sizeof(int))) {
+            _mm_stream_si32(row + j, i + j);
+            j++;
+        }
+        for (; j + lanes <= m.cols; j += lanes) {
+            #ifdef __AVX__
+                __m256i v = _mm256_setr_epi32(i + j,     i + j + 1, i + j + 2, i + j + 3,
+                                              i + j + 4, i + j + 5, i + j + 6, i + j + 7);
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(row + j), v);
+            #else
+                __m128i v = _mm_setr_epi32(i + j, i + j + 1, i + j + 2, i + j + 3);
+                _mm_stream_si128(reinterpret_cast<__m128i*>(row + j), v);
+            #endif
+        }
+        for (; j < m.cols; j++)
+            _mm_stream_si32(row + j, i + j);
+    }
+    _mm_sfence();
+#else
+    row_major_write(m);
+#endif
+}
+
+inline void column_major_stream(flat_matrix<int>& m) {
+#if BENCH_HAS_STREAM_STORES
+    for (int j = 0; j < m.cols; j++)
+        for (int i = 0; i < m.rows; i++)
+            _mm_stream_si32(&m.at(i, j), i + j);
+    _mm_sfence();
+#else
+    column_major_write(m);
+#endif
+}
+
+} // namespace bench
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "timer.h"
+
+namespace bench {
+
+// Log-linear histogram in the style of HdrHistogram: values below 64 get a bucket
+// each, and every power of two above that is split into 32 linear buckets, so any
+// recorded value is known to within about 3% however large it is.
+class latency_histogram {
+public:
+    void record(uint64_t value) {
+        size_t index = index_of(value);
+        if (index >= counts_.size())
+            counts_.resize(index + 1, 0);
+        counts_[index]++;
+        count_++;
+        max_ = std::max(max_, value);
+    }
+
+    void clear() {
+        counts_.clear();
+        count_ = 0;
+        max_   = 0;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+
+    // Smallest value that at least `quantile` (0..1) of the recorded values are at or
+    // below, reported as the top of its bucket and never above max().
+    uint64_t percentile(double quantile) const {
+        if (!count_)
+            return 0;
+        uint64_t target = std::max<uint64_t>(1, uint64_t(quantile * count_ + 0.5));
+        uint64_t seen   = 0;
+        for (size_t i = 0; i < counts_.size(); i++) {
+            seen += counts_[i];
+            if (seen >= target)
+                return std::min(max_, highest_in(i));
+        }
+        return max_;
+    }
+
+private:
+    static constexpr int      sub_bits = 5;
+    static constexpr uint64_t sub      = uint64_t(1) << sub_bits;
+
+    static size_t index_of(uint64_t v) {
+        if (v < 2 * sub)
+            return size_t(v);
+        int shift = std::bit_width(v) - 1 - sub_bits;
+        return size_t(sub * shift + (v >> shift));
+    }
+
+    static uint64_t highest_in(size_t index) {
+        if (index < 2 * sub)
+            return index;
+        int shift = int(index / sub) - 1;
+        return ((index - sub * shift) << shift) + (uint64_t(1) << shift) - 1;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t              count_ = 0;
+    uint64_t              max_   = 0;
+};
+
+// The unit a traversal is timed in: one row, one column or one square tile.
+enum class chunk_order { row, column, tiled };
+
+inline const char* chunk_order_name(chunk_order order) {
+    return order == chunk_order::row ? "row" : order == chunk_order::column ? "column" : "tiled";
+}
+
+// When a chunk started, relative to the first chunk of its call, and how long it took,
+// both in cycle_count() ticks.
+struct chunk_sample {
+    uint64_t start;
+    uint64_t ticks;
+};
+
+// Calls visit(i, j) on every element of a rows x cols matrix, chunk by chunk in
+// `order`, and records every chunk's duration in `hist`. With `timeline`, each chunk
+// is also appended to it.
+template <typename Visit>
+void timed_chunks(int rows, int cols, chunk_order order, int tile, Visit&& visit, latency_histogram& hist,
+                  std::vector<chunk_sample>* timeline = nullptr) {
+    uint64_t origin = cycle_count();
+    auto timed = [&](auto&& chunk) {
+        uint64_t start = cycle_count();
+        chunk();
+        uint64_t ticks = cycle_count() - start;
+        hist.record(ticks);
+        if (timeline)
+            timeline->push_back({start - origin, ticks});
+    };
+
+    switch (order) {
+    case chunk_order::row:
+        for (int i = 0; i < rows; i++)
+            timed([&] {
+                for (int j = 0; j < cols; j++)
+                    visit(i, j);
+            });
+        break;
+    case chunk_order::column:
+        for (int j = 0; j < cols; j++)
+            timed([&] {
+                for (int i = 0; i < rows; i++)
+                    visit(i, j);
+            });
+        break;
+    case chunk_order::tiled:
+        for (int ii = 0; ii < rows; ii += tile)
+            for (int jj = 0; jj < cols; jj += tile)
+                timed([&] {
+                    for (int i = ii; i < std::min(rows, ii + tile); i++)
+                        for (int j = jj; j < std::min(cols, jj + tile); j++)
+                            visit(i, j);
+                });
+        break;
+    }
+}
+
+} // namespace bench
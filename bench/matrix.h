@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+inline void* allocate_aligned(size_t bytes, size_t alignment = 64) {
+    // aligned_alloc requires the size to be a multiple of the alignment
+    bytes = (bytes + alignment - 1) / alignment * alignment;
+    #ifdef _WIN32
+        void* p = _aligned_malloc(bytes, alignment);
+    #else
+        void* p = std::aligned_alloc(alignment, bytes);
+    #endif
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+inline void free_aligned(void* p) {
+    #ifdef _WIN32
+        _aligned_free(p);
+    #else
+        free(p);
+    #endif
+}
+
+// Contiguous row-major matrix, 64-byte aligned like the matrices in test_allocated_aligned_matrix.
+// Rows are ld elements apart; ld defaults to col_size, anything larger pads every row.
+template <typename T = int>
+struct flat_matrix {
+    using value_type = T;
+
+    T*  data;
+    int rows;
+    int cols;
+    int ld;
+
+    flat_matrix(int row_size, int col_size, int leading_dim = 0)
+        : data(static_cast<T*>(allocate_aligned(size_t(row_size) * std::max(leading_dim, col_size) * sizeof(T)))),
+          rows(row_size), cols(col_size), ld(std::max(leading_dim, col_size)) {
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                at(i, j) = T(i + j);
+    }
+    ~flat_matrix() { free_aligned(data); }
+
+    flat_matrix(const flat_matrix&) = delete;
+    flat_matrix& operator=(const flat_matrix&) = delete;
+
+    T&       at(int i, int j)       { return data[size_t(i) * ld + j]; }
+    const T& at(int i, int j) const { return data[size_t(i) * ld + j]; }
+
+    size_t size() const { return size_t(rows) * cols; }
+};
+
+// Leading dimension of a row of col_size elements rounded up to whole cache lines.
+template <typename T>
+int line_padded_ld(int col_size, size_t line_size = 64) {
+    int per_line = int(std::max<size_t>(1, line_size / sizeof(T)));
+    return (col_size + per_line - 1) / per_line * per_line;
+}
+
+// Leading dimensions worth comparing for a row of col_size elements: no padding, a few
+// odd element counts (which break any power-of-two stride), one cache line and one page.
+template <typename T>
+std::vector<std::pair<std::string, int>> ld_padding_sweep(int col_size, size_t line_size = 64, size_t page_size = 4096) {
+    int line = int(std::max<size_t>(1, line_size / sizeof(T)));
+    int page = int(std::max<size_t>(1, page_size / sizeof(T)));
+    return {
+        {"none",        col_size},
+        {"+1 element",  col_size + 1},
+        {"+3 elements", col_size + 3},
+        {"+7 elements", col_size + 7},
+        {"+1 line",     col_size + line},
+        {"+1 page",     col_size + page},
+    };
+}
+
+// Array of separately allocated rows, the layout built by initialize_matrix in main.cpp.
+template <typename T = int>
+struct jagged_matrix {
+    using value_type = T;
+
+    T** data;
+    int rows;
+    int cols;
+
+    jagged_matrix(int row_size, int col_size)
+        : data(new T*[row_size]), rows(row_size), cols(col_size) {
+        for (int i = 0; i < rows; i++) {
+            data[i] = new T[cols];
+            for (int j = 0; j < cols; j++)
+                data[i][j] = T(i + j);
+        }
+    }
+    ~jagged_matrix() {
+        for (int i = 0; i < rows; i++)
+            delete[] data[i];
+        delete[] data;
+    }
+
+    jagged_matrix(const jagged_matrix&) = delete;
+    jagged_matrix& operator=(const jagged_matrix&) = delete;
+
+    T&       at(int i, int j)       { return data[i][j]; }
+    const T& at(int i, int j) const { return data[i][j]; }
+
+    size_t size() const { return size_t(rows) * cols; }
+};
+
+// The value initialize_matrix stores at (i, j).
+template <typename T = int>
+struct index_sum {
+    T operator()(int i, int j) const { return T(i + j); }
+};
+
+// Matrix with no storage: at(i, j) calls the generator, which the kernels inline
+// through the template, so traversing it costs arithmetic and no memory traffic.
+// Any functor of (i, j) works, e.g. a feature computed on demand.
+template <typename T = int, typename Generator = index_sum<T>>
+struct generated_matrix {
+    using value_type = T;
+
+    Generator generate;
+    int       rows;
+    int       cols;
+
+    generated_matrix(int row_size, int col_size, Generator g = Generator())
+        : generate(std::move(g)), rows(row_size), cols(col_size) {}
+
+    T at(int i, int j) const { return generate(i, j); }
+
+    size_t size() const { return size_t(rows) * cols; }
+};
+
+} // namespace bench
@@ -0,0 +1,448 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <version>
+#include "cache_info.h"
+#include "matrix.h"
+
+#if __has_include(<mdspan>)
+    #include <mdspan>
+#endif
+
+// bench::md is std::mdspan where the standard library has it (C++23, libstdc++ 14,
+// libc++ 17). Elsewhere it is a shim with the same names and member functions for the
+// part the kernels use: extents, dextents, layout_right, layout_left, default_accessor
+// and mdspan with a multidimensional operator[]. Layout policies written against it,
+// like the ones below, work with either.
+namespace bench::md {
+
+#if defined(__cpp_lib_mdspan)
+
+using std::default_accessor;
+using std::dextents;
+using std::dynamic_extent;
+using std::extents;
+using std::layout_left;
+using std::layout_right;
+using std::mdspan;
+
+#else
+
+inline constexpr size_t dynamic_extent = std::numeric_limits<size_t>::max();
+
+template <class IndexType, size_t... Extents>
+class extents {
+public:
+    using index_type = IndexType;
+    using size_type  = std::make_unsigned_t<IndexType>;
+    using rank_type  = size_t;
+
+    static constexpr rank_type rank() noexcept { return sizeof...(Extents); }
+    static constexpr rank_type rank_dynamic() noexcept { return ((Extents == dynamic_extent) + ... + 0); }
+    static constexpr size_t static_extent(rank_type r) noexcept { return std::array<size_t, rank()>{Extents...}[r]; }
+
+    constexpr extents() noexcept {
+        for (rank_type r = 0; r < rank(); r++)
+            extents_[r] = static_extent(r) == dynamic_extent ? 0 : index_type(static_extent(r));
+    }
+
+    // Either the dynamic extents alone or every extent, as in std::extents.
+    template <class... Indices>
+        requires(sizeof...(Indices) > 0 && (sizeof...(Indices) == rank_dynamic() || sizeof...(Indices) == rank()))
+    constexpr explicit extents(Indices... values) noexcept {
+        std::array<index_type, sizeof...(Indices)> given{index_type(values)...};
+        for (rank_type r = 0, d = 0; r < rank(); r++) {
+            if (sizeof...(Indices) == rank())
+                extents_[r] = given[r];
+            else
+                extents_[r] = static_extent(r) == dynamic_extent ? given[d++] : index_type(static_extent(r));
+        }
+    }
+
+    constexpr index_type extent(rank_type r) const noexcept { return extents_[r]; }
+
+    friend constexpr bool operator==(const extents& a, const extents& b) noexcept { return a.extents_ == b.extents_; }
+
+private:
+    std::array<index_type, rank()> extents_{};
+};
+
+namespace internal {
+    template <class IndexType, class Sequence>
+    struct dextents_for;
+
+    template <class IndexType, size_t... R>
+    struct dextents_for<IndexType, std::index_sequence<R...>> {
+        using type = extents<IndexType, ((void)R, dynamic_extent)...>;
+    };
+} // namespace internal
+
+template <class IndexType, size_t Rank>
+using dextents = typename internal::dextents_for<IndexType, std::make_index_sequence<Rank>>::type;
+
+struct layout_right {
+    template <class Extents>
+    class mapping {
+    public:
+        using extents_type = Extents;
+        using index_type   = typename Extents::index_type;
+        using size_type    = typename Extents::size_type;
+        using rank_type    = typename Extents::rank_type;
+        using layout_type  = layout_right;
+
+        constexpr mapping() noexcept = default;
+        constexpr mapping(const extents_type& e) noexcept : extents_(e) {}
+
+        constexpr const extents_type& extents() const noexcept { return extents_; }
+
+        template <class... Indices>
+        constexpr index_type operator()(Indices... idx) const noexcept {
+            index_type i[] = {index_type(idx)...}, off = 0;
+            for (rank_type r = 0; r < extents_type::rank(); r++)
+                off = off * extents_.extent(r) + i[r];
+            return off;
+        }
+
+        constexpr index_type required_span_size() const noexcept {
+            index_type n = 1;
+            for (rank_type r = 0; r < extents_type::rank(); r++)
+                n *= extents_.extent(r);
+            return n;
+        }
+        constexpr index_type stride(rank_type r) const noexcept {
+            index_type s = 1;
+            for (rank_type k = r + 1; k < extents_type::rank(); k++)
+                s *= extents_.extent(k);
+            return s;
+        }
+
+        static constexpr bool is_always_unique() noexcept { return true; }
+        static constexpr bool is_always_exhaustive() noexcept { return true; }
+        static constexpr bool is_always_strided() noexcept { return true; }
+        static constexpr bool is_unique() noexcept { return true; }
+        static constexpr bool is_exhaustive() noexcept { return true; }
+        static constexpr bool is_strided() noexcept { return true; }
+
+        friend constexpr bool operator==(const mapping& a, const mapping& b) noexcept { return a.extents_ == b.extents_; }
+
+    private:
+        extents_type extents_{};
+    };
+};
+
+struct layout_left {
+    template <class Extents>
+    class mapping {
+    public:
+        using extents_type = Extents;
+        using index_type   = typename Extents::index_type;
+        using size_type    = typename Extents::size_type;
+        using rank_type    = typename Extents::rank_type;
+        using layout_type  = layout_left;
+
+        constexpr mapping() noexcept = default;
+        constexpr mapping(const extents_type& e) noexcept : extents_(e) {}
+
+        constexpr const extents_type& extents() const noexcept { return extents_; }
+
+        template <class... Indices>
+        constexpr index_type operator()(Indices... idx) const noexcept {
+            index_type i[] = {index_type(idx)...}, off = 0;
+            for (rank_type r = extents_type::rank(); r-- > 0;)
+                off = off * extents_.extent(r) + i[r];
+            return off;
+        }
+
+        constexpr index_type required_span_size() const noexcept {
+            index_type n = 1;
+            for (rank_type r = 0; r < extents_type::rank(); r++)
+                n *= extents_.extent(r);
+            return n;
+        }
+        constexpr index_type stride(rank_type r) const noexcept {
+            index_type s = 1;
+            for (rank_type k = 0; k < r; k++)
+                s *= extents_.extent(k);
+            return s;
+        }
+
+        static constexpr bool is_always_unique() noexcept { return true; }
+        static constexpr bool is_always_exhaustive() noexcept { return true; }
+        static constexpr bool is_always_strided() noexcept { return true; }
+        static constexpr bool is_unique() noexcept { return true; }
+        static constexpr bool is_exhaustive() noexcept { return true; }
+        static constexpr bool is_strided() noexcept { return true; }
+
+        friend constexpr bool operator==(const mapping& a, const mapping& b) noexcept { return a.extents_ == b.extents_; }
+
+    private:
+        extents_type extents_{};
+    };
+};
+
+template <class T>
+struct default_accessor {
+    using offset_policy    = default_accessor;
+    using element_type     = T;
+    using reference        = T&;
+    using data_handle_type = T*;
+
+    constexpr reference access(data_handle_type p, size_t i) const noexcept { return p[i]; }
+    constexpr data_handle_type offset(data_handle_type p, size_t i) const noexcept { return p + i; }
+};
+
+template <class T, class Extents, class LayoutPolicy = layout_right, class Accessor = default_accessor<T>>
+class mdspan {
+public:
+    using extents_type     = Extents;
+    using layout_type      = LayoutPolicy;
+    using accessor_type    = Accessor;
+    using mapping_type     = typename LayoutPolicy::template mapping<Extents>;
+    using element_type     = T;
+    using value_type       = std::remove_cv_t<T>;
+    using index_type       = typename Extents::index_type;
+    using size_type        = typename Extents::size_type;
+    using rank_type        = typename Extents::rank_type;
+    using data_handle_type = typename Accessor::data_handle_type;
+    using reference        = typename Accessor::reference;
+
+    constexpr mdspan() = default;
+    constexpr mdspan(data_handle_type p, const mapping_type& m) : ptr_(p), map_(m) {}
+    constexpr mdspan(data_handle_type p, const extents_type& e) : ptr_(p), map_(e) {}
+
+    template <class... Indices>
+        requires(sizeof...(Indices) == Extents::rank())
+    constexpr reference operator[](Indices... idx) const {
+        return acc_.access(ptr_, size_t(map_(index_type(idx)...)));
+    }
+
+    static constexpr rank_type rank() noexcept { return Extents::rank(); }
+    constexpr index_type extent(rank_type r) const noexcept { return map_.extents().extent(r); }
+    constexpr const extents_type& extents() const noexcept { return map_.extents(); }
+    constexpr size_type size() const noexcept {
+        size_type n = 1;
+        for (rank_type r = 0; r < rank(); r++)
+            n *= size_type(extent(r));
+        return n;
+    }
+
+    constexpr const data_handle_type& data_handle() const noexcept { return ptr_; }
+    constexpr const mapping_type& mapping() const noexcept { return map_; }
+    constexpr const accessor_type& accessor() const noexcept { return acc_; }
+
+private:
+    data_handle_type ptr_ = nullptr;
+    mapping_type     map_{};
+    accessor_type    acc_{};
+};
+
+#endif
+
+} // namespace bench::md
+
+namespace bench {
+
+// Custom layout policies for rank-2 extents. Each is a std layout mapping policy:
+// a nested mapping<Extents> with operator(), required_span_size() and the
+// is_unique/is_exhaustive/is_strided queries, so it plugs into md::mdspan, std or shim.
+// Any other policy with the same members drops into the same kernels.
+
+// Row-major with every row padded to a multiple of RowAlign elements, like
+// line_padded_ld. With the default dynamic_extent the alignment is a run-time argument
+// of the mapping (md_matrix passes one detected cache line of its element type), and
+// the extents-only constructor pads nothing, as std::layout_right_padded does.
+template <size_t RowAlign = md::dynamic_extent>
+struct layout_padded {
+    template <class Extents>
+    class mapping {
+    public:
+        static_assert(Extents::rank() == 2, "layout_padded is rank 2");
+        using extents_type = Extents;
+        using index_type   = typename Extents::index_type;
+        using size_type    = typename Extents::size_type;
+        using rank_type    = typename Extents::rank_type;
+        using layout_type  = layout_padded;
+
+        constexpr mapping() noexcept = default;
+        constexpr mapping(const extents_type& e) noexcept
+            : extents_(e), ld_(padded_ld(e, RowAlign == md::dynamic_extent ? 1 : RowAlign)) {}
+        constexpr mapping(const extents_type& e, size_t row_align) noexcept
+            requires(RowAlign == md::dynamic_extent)
+            : extents_(e), ld_(padded_ld(e, row_align)) {}
+
+        constexpr const extents_type& extents() const noexcept { return extents_; }
+        constexpr index_type operator()(index_type i, index_type j) const noexcept { return i * ld_ + j; }
+        constexpr index_type required_span_size() const noexcept { return extents_.extent(0) * ld_; }
+        constexpr index_type stride(rank_type r) const noexcept { return r == 0 ? ld_ : 1; }
+
+        static constexpr bool is_always_unique() noexcept { return true; }
+        static constexpr bool is_always_exhaustive() noexcept { return false; }
+        static constexpr bool is_always_strided() noexcept { return true; }
+        static constexpr bool is_unique() noexcept { return true; }
+        constexpr bool is_exhaustive() const noexcept { return ld_ == extents_.extent(1); }
+        static constexpr bool is_strided() noexcept { return true; }
+
+        friend constexpr bool operator==(const mapping& a, const mapping& b) noexcept { return a.extents_ == b.extents_; }
+
+    private:
+        static constexpr index_type padded_ld(const extents_type& e, size_t row_align) noexcept {
+            row_align = std::max<size_t>(1, row_align);
+            return index_type((size_t(e.extent(1)) + row_align - 1) / row_align * row_align);
+        }
+
+        extents_type extents_{};
+        index_type   ld_ = 0;
+    };
+};
+
+// TileRows x TileCols tiles stored one after another in row-major tile order, each
+// tile row-major inside. Edges are padded to whole tiles. 16 x 16 ints is 1 KiB.
+template <size_t TileRows = 16, size_t TileCols = 16>
+struct layout_tiled {
+    template <class Extents>
+    class mapping {
+    public:
+        static_assert(Extents::rank() == 2, "layout_tiled is rank 2");
+        using extents_type = Extents;
+        using index_type   = typename Extents::index_type;
+        using size_type    = typename Extents::size_type;
+        using rank_type    = typename Extents::rank_type;
+        using layout_type  = layout_tiled;
+
+        constexpr mapping() noexcept = default;
+        constexpr mapping(const extents_type& e) noexcept
+            : extents_(e), tiles_per_row_(index_type((size_t(e.extent(1)) + TileCols - 1) / TileCols)) {}
+
+        constexpr const extents_type& extents() const noexcept { return extents_; }
+        constexpr index_type operator()(index_type i, index_type j) const noexcept {
+            index_type tile = (i / index_type(TileRows)) * tiles_per_row_ + j / index_type(TileCols);
+            return tile * index_type(TileRows * TileCols) + (i % index_type(TileRows)) * index_type(TileCols)
+                 + j % index_type(TileCols);
+        }
+        constexpr index_type required_span_size() const noexcept {
+            index_type tile_rows = index_type((size_t(extents_.extent(0)) + TileRows - 1) / TileRows);
+            return tile_rows * tiles_per_row_ * index_type(TileRows * TileCols);
+        }
+        constexpr index_type stride(rank_type) const noexcept { return 0; } // not strided
+
+        static constexpr bool is_always_unique() noexcept { return true; }
+        static constexpr bool is_always_exhaustive() noexcept { return false; }
+        static constexpr bool is_always_strided() noexcept { return false; }
+        static constexpr bool is_unique() noexcept { return true; }
+        constexpr bool is_exhaustive() const noexcept { return required_span_size() == extents_.extent(0) * extents_.extent(1); }
+        static constexpr bool is_strided() noexcept { return false; }
+
+        friend constexpr bool operator==(const mapping& a, const mapping& b) noexcept { return a.extents_ == b.extents_; }
+
+    private:
+        extents_type extents_{};
+        index_type   tiles_per_row_ = 0;
+    };
+};
+
+namespace internal {
+    // Moves bit k of x to bit 2k.
+    constexpr uint64_t spread_bits(uint32_t x) noexcept {
+        uint64_t v = x;
+        v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+        v = (v | (v << 8))  & 0x00FF00FF00FF00FFull;
+        v = (v | (v << 4))  & 0x0F0F0F0F0F0F0F0Full;
+        v = (v | (v << 2))  & 0x3333333333333333ull;
+        v = (v | (v << 1))  & 0x5555555555555555ull;
+        return v;
+    }
+} // namespace internal
+
+// Morton (Z-order): the low bits of i and j are interleaved, i in the odd positions,
+// so every aligned 2^k x 2^k square is contiguous. Both extents are rounded up to
+// powers of two; the high bits of the longer one, beyond the shorter one's, select
+// one of several square Morton blocks laid end to end.
+struct layout_morton {
+    template <class Extents>
+    class mapping {
+    public:
+        static_assert(Extents::rank() == 2, "layout_morton is rank 2");
+        using extents_type = Extents;
+        using index_type   = typename Extents::index_type;
+        using size_type    = typename Extents::size_type;
+        using rank_type    = typename Extents::rank_type;
+        using layout_type  = layout_morton;
+
+        constexpr mapping() noexcept = default;
+        constexpr mapping(const extents_type& e) noexcept : extents_(e) {
+            size_t rows = std::bit_ceil(size_t(e.extent(0))), cols = std::bit_ceil(size_t(e.extent(1)));
+            bits_ = std::countr_zero(std::min(rows, cols));
+            span_ = index_type(rows * cols);
+        }
+
+        constexpr const extents_type& extents() const noexcept { return extents_; }
+        constexpr index_type operator()(index_type i, index_type j) const noexcept {
+            uint32_t mask = (uint32_t(1) << bits_) - 1;
+            uint64_t low  = internal::spread_bits(uint32_t(i) & mask) << 1 | internal::spread_bits(uint32_t(j) & mask);
+            uint64_t high = (uint64_t(i) >> bits_) + (uint64_t(j) >> bits_); // at most one is non-zero
+            return index_type(high << (2 * bits_) | low);
+        }
+        constexpr index_type required_span_size() const noexcept { return span_; }
+        constexpr index_type stride(rank_type) const noexcept { return 0; } // not strided
+
+        static constexpr bool is_always_unique() noexcept { return true; }
+        static constexpr bool is_always_exhaustive() noexcept { return false; }
+        static constexpr bool is_always_strided() noexcept { return false; }
+        static constexpr bool is_unique() noexcept { return true; }
+        constexpr bool is_exhaustive() const noexcept { return span_ == extents_.extent(0) * extents_.extent(1); }
+        static constexpr bool is_strided() noexcept { return false; }
+
+        friend constexpr bool operator==(const mapping& a, const mapping& b) noexcept { return a.extents_ == b.extents_; }
+
+    private:
+        extents_type extents_{};
+        int          bits_ = 0;
+        index_type   span_ = 0;
+    };
+};
+
+// Owns the storage behind a rank-2 md::mdspan with layout policy Layout, initialized
+// to i + j like the other matrices. Kernels take view().
+template <typename T, class Layout>
+class md_matrix {
+public:
+    using value_type = T;
+    using view_type  = md::mdspan<T, md::dextents<size_t, 2>, Layout>;
+
+    md_matrix(int row_size, int col_size) {
+        using mapping_type = typename view_type::mapping_type;
+        md::dextents<size_t, 2> exts{size_t(row_size), size_t(col_size)};
+        mapping_type map{exts};
+        if constexpr (std::is_constructible_v<mapping_type, const md::dextents<size_t, 2>&, size_t>)
+            map = mapping_type(exts, std::max<size_t>(1, host_cache_topology().line_size / sizeof(T)));
+        span_ = map.required_span_size();
+        data_ = static_cast<T*>(allocate_aligned(span_ * sizeof(T)));
+        view_ = view_type(data_, map);
+        for (int i = 0; i < row_size; i++)
+            for (int j = 0; j < col_size; j++)
+                view_[i, j] = T(i + j);
+    }
+    ~md_matrix() { free_aligned(data_); }
+
+    md_matrix(const md_matrix&) = delete;
+    md_matrix& operator=(const md_matrix&) = delete;
+
+    view_type view() const { return view_; }
+    size_t    size() const { return view_.size(); }
+    // Elements allocated, padding included.
+    size_t    span() const { return span_; }
+
+private:
+    T*        data_ = nullptr;
+    size_t    span_ = 0;
+    view_type view_;
+};
+
+} // namespace bench
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "kernels.h"
+#include "matrix.h"
+#include "thread_timing.h"
+
+#if defined(_OPENMP)
+    #include <omp.h>
+    #define BENCH_HAS_OPENMP 1
+#else
+    #define BENCH_HAS_OPENMP 0
+#endif
+
+namespace bench {
+
+// OpenMP versions of the row, column and tiled traversals, driven by schedule(runtime)
+// so one loop nest per traversal covers every schedule and chunk size. Without OpenMP
+// the pragmas are ignored and the kernels run serially.
+
+enum class omp_traversal { row, column, tiled };
+
+inline const char* omp_traversal_name(omp_traversal t) {
+    switch (t) {
+    case omp_traversal::row:    return "row";
+    case omp_traversal::column: return "column";
+    default:                    return "tiled";
+    }
+}
+
+enum class omp_schedule { static_, dynamic, guided };
+
+struct omp_policy {
+    omp_schedule kind;
+    int          chunk;    // 0 is the schedule's default
+    bool         collapse; // collapse(2): chunks count elements (tiles when tiled), not rows
+
+    std::string name() const {
+        std::string s = kind == omp_schedule::static_ ? "static" : kind == omp_schedule::dynamic ? "dynamic" : "guided";
+        s += chunk ? "," + std::to_string(chunk) : "";
+        return collapse ? s + " collapse(2)" : s;
+    }
+};
+
+// Every schedule with the default chunk and chunks of 1, 16 and 256, each with and
+// without collapse(2).
+inline std::vector<omp_policy> omp_policy_sweep() {
+    std::vector<omp_policy> policies;
+    for (omp_schedule kind : {omp_schedule::static_, omp_schedule::dynamic, omp_schedule::guided})
+        for (int chunk : {0, 1, 16, 256})
+            for (bool collapse : {false, true})
+                policies.push_back({kind, chunk, collapse});
+    return policies;
+}
+
+inline int omp_max_threads() {
+#if BENCH_HAS_OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+inline int omp_thread_num() {
+#if BENCH_HAS_OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+inline int omp_team_size() {
+#if BENCH_HAS_OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+// Sum of every element on `threads` threads. The tiled traversal walks square tiles of
+// `tile` elements in row order, each tile in row order, and distributes whole tiles.
+// With `timings`, each thread of the team records when its share of the loop started
+// and finished; the loop has no closing barrier, so a thread's end is its own. Shares
+// vary by schedule, so bytes is left at 0.
+template <typename Matrix>
+auto omp_sum(const Matrix& m, omp_traversal order, const omp_policy& policy, int threads, int tile,
+             std::vector<thread_timing>* timings = nullptr) {
+    accumulator_t<typename Matrix::value_type> sum = 0;
+    const int rows = m.rows, cols = m.cols;
+    const int tile_rows = (rows + tile - 1) / tile, tile_cols = (cols + tile - 1) / tile;
+    int team = 1;
+    if (timings)
+        timings->assign(std::max(threads, 1), thread_timing{});
+
+#if BENCH_HAS_OPENMP
+    omp_sched_t kind = policy.kind == omp_schedule::static_ ? omp_sched_static
+                     : policy.kind == omp_schedule::dynamic ? omp_sched_dynamic : omp_sched_guided;
+    omp_set_schedule(kind, policy.chunk);
+#endif
+
+    auto origin = thread_clock::now();
+#pragma omp parallel num_threads(threads) reduction(+ : sum)
+    {
+        auto start = thread_clock::now();
+        switch (order) {
+        case omp_traversal::row:
+            if (policy.collapse) {
+#pragma omp for collapse(2) schedule(runtime) nowait
+                for (int i = 0; i < rows; i++)
+                    for (int j = 0; j < cols; j++)
+                        sum += m.at(i, j);
+            } else {
+#pragma omp for schedule(runtime) nowait
+                for (int i = 0; i < rows; i++)
+                    for (int j = 0; j < cols; j++)
+                        sum += m.at(i, j);
+            }
+            break;
+        case omp_traversal::column:
+            if (policy.collapse) {
+#pragma omp for collapse(2) schedule(runtime) nowait
+                for (int j = 0; j < cols; j++)
+                    for (int i = 0; i < rows; i++)
+                        sum += m.at(i, j);
+            } else {
+#pragma omp for schedule(runtime) nowait
+                for (int j = 0; j < cols; j++)
+                    for (int i = 0; i < rows; i++)
+                        sum += m.at(i, j);
+            }
+            break;
+        case omp_traversal::tiled:
+            if (policy.collapse) {
+#pragma omp for collapse(2) schedule(runtime) nowait
+                for (int ti = 0; ti < tile_rows; ti++)
+                    for (int tj = 0; tj < tile_cols; tj++)
+                        for (int i = ti * tile; i < std::min(rows, (ti + 1) * tile); i++)
+                            for (int j = tj * tile; j < std::min(cols, (tj + 1) * tile); j++)
+                                sum += m.at(i, j);
+            } else {
+#pragma omp for schedule(runtime) nowait
+                for (int ti = 0; ti < tile_rows; ti++)
+                    for (int tj = 0; tj < tile_cols; tj++)
+                        for (int i = ti * tile; i < std::min(rows, (ti + 1) * tile); i++)
+                            for (int j = tj * tile; j < std::min(cols, (tj + 1) * tile); j++)
+                                sum += m.at(i, j);
+            }
+            break;
+        }
+        if (timings) {
+            int t = omp_thread_num();
+            if (t < int(timings->size()))
+                record_thread((*timings)[t], origin, start, 0);
+            if (t == 0)
+                team = omp_team_size();
+        }
+    }
+    if (timings)
+        timings->resize(std::min(team, int(timings->size())));
+    return sum;
+}
+
+} // namespace bench
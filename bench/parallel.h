@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "thread_timing.h"
+
+namespace bench {
+
+// Splits [0, count) into `threads` contiguous bands and runs body(first, last) on each,
+// the calling thread taking the first band. Returns once every band is done. With
+// `timings`, thread t's share of the call is recorded in (*timings)[t], counting
+// bytes_per_item bytes for every index in its band.
+template <typename Body>
+void parallel_for(int threads, int count, Body&& body, std::vector<thread_timing>* timings = nullptr,
+                  size_t bytes_per_item = 0) {
+    threads = std::max(1, std::min(threads, count));
+    auto origin = thread_clock::now();
+    if (timings)
+        timings->assign(threads, {});
+    auto band = [&](int t, int first, int last) {
+        auto start = thread_clock::now();
+        body(first, last);
+        if (timings)
+            record_thread((*timings)[t], origin, start, size_t(last - first) * bytes_per_item);
+    };
+    if (threads == 1) {
+        band(0, 0, count);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (int t = 1; t < threads; t++) {
+        int first = int(static_cast<long long>(count) * t / threads);
+        int last  = int(static_cast<long long>(count) * (t + 1) / threads);
+        workers.emplace_back([&band, t, first, last] { band(t, first, last); });
+    }
+    band(0, 0, count / threads);
+    for (auto& w : workers)
+        w.join();
+}
+
+} // namespace bench
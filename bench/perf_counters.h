@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace bench {
+
+// One hardware event counted over the calling thread and every thread it starts after
+// the counter is opened (child counts are folded in when those threads exit).
+// Unavailable off Linux, in most containers and under a strict perf_event_paranoid;
+// callers check available() and report "n/a".
+class perf_counter {
+public:
+    perf_counter(std::string name, uint32_t type, uint64_t config) : name_(std::move(name)) {
+    #ifdef __linux__
+        perf_event_attr attr{};
+        attr.size           = sizeof(attr);
+        attr.type           = type;
+        attr.config         = config;
+        attr.disabled       = 1;
+        attr.inherit        = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        fd_ = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    #else
+        (void)type;
+        (void)config;
+    #endif
+    }
+    ~perf_counter() {
+    #ifdef __linux__
+        if (fd_ >= 0)
+            close(fd_);
+    #endif
+    }
+
+    perf_counter(const perf_counter&) = delete;
+    perf_counter& operator=(const perf_counter&) = delete;
+
+    bool               available() const { return fd_ >= 0; }
+    const std::string& name()      const { return name_; }
+
+    void start() {
+    #ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    #endif
+    }
+
+    void stop() {
+    #ifdef __linux__
+        if (fd_ >= 0)
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    #endif
+    }
+
+    uint64_t value() const {
+        uint64_t count = 0;
+    #ifdef __linux__
+        if (fd_ >= 0 && read(fd_, &count, sizeof(count)) != sizeof(count))
+            count = 0;
+    #endif
+        return count;
+    }
+
+private:
+    std::string name_;
+    int         fd_ = -1;
+};
+
+#ifdef __linux__
+// Generic L1D read misses and LLC misses. A line stolen by another core's store shows up
+// among the L1D misses, but so does every other miss: neither event counts HITM or snoop
+// responses, so they bound coherence traffic from above rather than measure it.
+inline perf_counter l1d_miss_counter() {
+    return perf_counter("L1D misses", PERF_TYPE_HW_CACHE,
+                        PERF_COUNT_HW_CACHE_L1D |
+                        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+}
+
+inline perf_counter llc_miss_counter() {
+    return perf_counter("LLC misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+}
+#else
+inline perf_counter l1d_miss_counter() { return perf_counter("L1D misses", 0, 0); }
+inline perf_counter llc_miss_counter() { return perf_counter("LLC misses", 0, 0); }
+#endif
+
+} // namespace bench
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+    #include <time.h>
+    #define BENCH_HAS_AFFINITY 1
+#else
+    #define BENCH_HAS_AFFINITY 0
+#endif
+
+namespace bench {
+
+// CPUs this process may run on, in ascending order; empty when unknown.
+inline std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+#if BENCH_HAS_AFFINITY
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        for (int c = 0; c < CPU_SETSIZE; c++)
+            if (CPU_ISSET(c, &set))
+                cpus.push_back(c);
+#endif
+    return cpus;
+}
+
+// Restricts the calling thread to `cpus`. Returns false when that is not possible.
+inline bool pin_current_thread(const std::vector<int>& cpus) {
+#if BENCH_HAS_AFFINITY
+    if (cpus.empty())
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus)
+        CPU_SET(c, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+// Measurement keeps the first allowed CPU, setup gets the rest. With a single CPU
+// nothing is pinned and both run wherever the scheduler puts them.
+struct cpu_split {
+    std::vector<int> measure;
+    std::vector<int> setup;
+
+    bool isolated() const { return !measure.empty() && !setup.empty(); }
+};
+
+inline cpu_split split_cpus_for_pipeline() {
+    cpu_split split;
+    std::vector<int> cpus = allowed_cpus();
+    if (cpus.size() >= 2) {
+        split.measure = {cpus.front()};
+        split.setup.assign(cpus.begin() + 1, cpus.end());
+    }
+    return split;
+}
+
+// CPU time of the calling thread in milliseconds, page faults included; the wall clock
+// where that is unavailable. Unlike the wall clock it does not grow while setup and
+// measurement wait for each other on a shared CPU.
+inline double thread_cpu_ms() {
+#if BENCH_HAS_AFFINITY
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+#endif
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct pipeline_timing {
+    double setup_ms   = 0; // CPU time of setup and teardown, summed over every item
+    double measure_ms = 0; // CPU time of measure, one call per item
+    double check_ms   = 0; // CPU time of the optional check calls, also part of wall_ms
+    double wall_ms    = 0; // start of the first setup to the end of the last teardown
+    bool   isolated   = false;
+
+    // What a serial run (setup, one measure and teardown per item) would have taken minus
+    // what this one took, check calls included: negative when they cost more than the
+    // overlap hid.
+    double saved_ms() const { return setup_ms + measure_ms - wall_ms; }
+};
+
+// Runs setup(i), measure(i, item, overlapped) and teardown(i, item) for i in [0, count),
+// setting up item i + 1 on a background thread while item i is measured.
+// measure is called with overlapped = true while that setup is in flight, and that call
+// is the item's result. With `check` it is called once more with overlapped = false
+// after the setup has finished, so the two results show whether the overlap disturbed
+// the measurement; that costs about one more measurement per item.
+template <typename Setup, typename Measure, typename Teardown>
+pipeline_timing run_pipelined(int count, Setup&& setup, Measure&& measure, Teardown&& teardown, bool check = false) {
+    using item_t = decltype(setup(0));
+    using clock  = std::chrono::steady_clock;
+    auto ms_since = [](clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    };
+
+    pipeline_timing timing;
+    std::vector<int> all  = allowed_cpus();
+    cpu_split        cpus = split_cpus_for_pipeline();
+    timing.isolated       = cpus.isolated() && pin_current_thread(cpus.measure);
+
+    if (count <= 0) {
+        if (timing.isolated)
+            pin_current_thread(all);
+        return timing;
+    }
+
+    auto wall_start = clock::now();
+    auto timed_setup = [&](int i, item_t& out, double& ms) {
+        double start = thread_cpu_ms();
+        out = setup(i);
+        ms  = thread_cpu_ms() - start;
+    };
+
+    item_t current{};
+    double setup_ms = 0;
+    timed_setup(0, current, setup_ms);
+    timing.setup_ms += setup_ms;
+
+    for (int i = 0; i < count; i++) {
+        item_t      next{};
+        double      next_ms = 0;
+        std::thread worker;
+        if (i + 1 < count)
+            worker = std::thread([&, i] {
+                if (timing.isolated)
+                    pin_current_thread(cpus.setup);
+                timed_setup(i + 1, next, next_ms);
+            });
+
+        double start = thread_cpu_ms();
+        measure(i, current, worker.joinable());
+        timing.measure_ms += thread_cpu_ms() - start;
+
+        if (worker.joinable()) {
+            worker.join();
+            timing.setup_ms += next_ms;
+            if (check) {
+                start = thread_cpu_ms();
+                measure(i, current, false);
+                timing.check_ms += thread_cpu_ms() - start;
+            }
+        }
+        start = thread_cpu_ms();
+        teardown(i, current);
+        timing.setup_ms += thread_cpu_ms() - start;
+        current = std::move(next);
+    }
+    timing.wall_ms = ms_since(wall_start);
+    if (timing.isolated)
+        pin_current_thread(all);
+    return timing;
+}
+
+} // namespace bench
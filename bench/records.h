@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "matrix.h"
+
+namespace bench {
+
+// A multi-field element: eight int fields, 32 bytes, two to a 64-byte line.
+constexpr int record_fields = 8;
+
+struct record {
+    int field[record_fields];
+};
+
+// Records per AoSoA block: one SIMD register of ints.
+#if defined(__AVX__)
+constexpr int simd_ints = 8;
+#else
+constexpr int simd_ints = 4;
+#endif
+
+// The three layouts below hold a rows x cols matrix of records, each field of (i, j)
+// initialized to i + j + field. at(i, j, f) is the only way the kernels reach a field.
+
+// Array of structs: whole records one after another.
+struct aos_matrix {
+    static constexpr const char* name = "aos";
+
+    record* data;
+    int     rows;
+    int     cols;
+
+    aos_matrix(int row_size, int col_size)
+        : data(static_cast<record*>(allocate_aligned(size_t(row_size) * col_size * sizeof(record)))),
+          rows(row_size), cols(col_size) {
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                for (int f = 0; f < record_fields; f++)
+                    at(i, j, f) = i + j + f;
+    }
+    ~aos_matrix() { free_aligned(data); }
+
+    aos_matrix(const aos_matrix&) = delete;
+    aos_matrix& operator=(const aos_matrix&) = delete;
+
+    int&       at(int i, int j, int f)       { return data[size_t(i) * cols + j].field[f]; }
+    const int& at(int i, int j, int f) const { return data[size_t(i) * cols + j].field[f]; }
+
+    size_t size() const { return size_t(rows) * cols; }
+};
+
+// Struct of arrays: one row-major int matrix per field, each starting on a new line.
+struct soa_matrix {
+    static constexpr const char* name = "soa";
+
+    int*   data;
+    int    rows;
+    int    cols;
+    size_t stride; // ints from one field's array to the next
+
+    soa_matrix(int row_size, int col_size)
+        : rows(row_size), cols(col_size), stride((size_t(row_size) * col_size + 15) / 16 * 16) {
+        data = static_cast<int*>(allocate_aligned(stride * record_fields * sizeof(int)));
+        for (int f = 0; f < record_fields; f++)
+            for (int i = 0; i < rows; i++)
+                for (int j = 0; j < cols; j++)
+                    at(i, j, f) = i + j + f;
+    }
+    ~soa_matrix() { free_aligned(data); }
+
+    soa_matrix(const soa_matrix&) = delete;
+    soa_matrix& operator=(const soa_matrix&) = delete;
+
+    int&       at(int i, int j, int f)       { return data[f * stride + size_t(i) * cols + j]; }
+    const int& at(int i, int j, int f) const { return data[f * stride + size_t(i) * cols + j]; }
+
+    size_t size() const { return size_t(rows) * cols; }
+};
+
+// Array of structs of arrays: blocks of simd_ints records, each block storing field 0
+// of all of them, then field 1, and so on. Records are numbered in row-major order.
+struct aosoa_matrix {
+    static constexpr const char* name = "aosoa";
+
+    int* data;
+    int  rows;
+    int  cols;
+
+    aosoa_matrix(int row_size, int col_size)
+        : data(static_cast<int*>(allocate_aligned(blocks(row_size, col_size) * simd_ints * record_fields * sizeof(int)))),
+          rows(row_size), cols(col_size) {
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                for (int f = 0; f < record_fields; f++)
+                    at(i, j, f) = i + j + f;
+    }
+    ~aosoa_matrix() { free_aligned(data); }
+
+    aosoa_matrix(const aosoa_matrix&) = delete;
+    aosoa_matrix& operator=(const aosoa_matrix&) = delete;
+
+    int& at(int i, int j, int f) { return data[index(i, j, f)]; }
+    const int& at(int i, int j, int f) const { return data[index(i, j, f)]; }
+
+    size_t size() const { return size_t(rows) * cols; }
+
+private:
+    static size_t blocks(int row_size, int col_size) { return (size_t(row_size) * col_size + simd_ints - 1) / simd_ints; }
+
+    size_t index(int i, int j, int f) const {
+        size_t e = size_t(i) * cols + j;
+        return (e / simd_ints) * simd_ints * record_fields + size_t(f) * simd_ints + e % simd_ints;
+    }
+};
+
+// Sum of the first `fields` fields of every record.
+
+template <typename Layout>
+size_t row_major_fields_sum(const Layout& m, int fields) {
+    size_t sum = 0;
+    for (int i = 0; i < m.rows; i++)
+        for (int j = 0; j < m.cols; j++)
+            for (int f = 0; f < fields; f++)
+                sum += m.at(i, j, f);
+    return sum;
+}
+
+template <typename Layout>
+size_t column_major_fields_sum(const Layout& m, int fields) {
+    size_t sum = 0;
+    for (int j = 0; j < m.cols; j++)
+        for (int i = 0; i < m.rows; i++)
+            for (int f = 0; f < fields; f++)
+                sum += m.at(i, j, f);
+    return sum;
+}
+
+// Distinct cache lines holding the first `fields` fields of every record. Every line
+// has to be brought in at least once, so line_size minus the useful bytes per line is
+// the least a traversal can waste; column order wastes more when lines are evicted
+// before their other records are reached.
+template <typename Layout>
+size_t touched_lines(const Layout& m, int fields, size_t line_size) {
+    auto line_of = [&](int i, int j, int f) { return reinterpret_cast<uintptr_t>(&m.at(i, j, f)) / line_size; };
+    auto for_each_field = [&](auto&& visit) {
+        for (int i = 0; i < m.rows; i++)
+            for (int j = 0; j < m.cols; j++)
+                for (int f = 0; f < fields; f++)
+                    visit(line_of(i, j, f));
+    };
+
+    uintptr_t first = line_of(0, 0, 0), last = first;
+    for_each_field([&](uintptr_t line) {
+        first = std::min(first, line);
+        last  = std::max(last, line);
+    });
+    std::vector<bool> seen(last - first + 1);
+    size_t count = 0;
+    for_each_field([&](uintptr_t line) {
+        if (!seen[line - first]) {
+            seen[line - first] = true;
+            count++;
+        }
+    });
+    return count;
+}
+
+} // namespace bench
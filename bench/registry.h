@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <regex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../kaizen.h"
+#include "timer.h"
+
+namespace bench {
+
+struct stats {
+    double min    = 0;
+    double median = 0;
+    double mean   = 0;
+    double stddev = 0;
+    int    count  = 0;
+};
+
+inline stats summarize(std::vector<double> samples) {
+    stats s;
+    if (samples.empty())
+        return s;
+
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    s.count  = int(n);
+    s.min    = samples.front();
+    s.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    for (double x : samples)
+        s.mean += x;
+    s.mean /= n;
+    for (double x : samples)
+        s.stddev += (x - s.mean) * (x - s.mean);
+    s.stddev = n > 1 ? std::sqrt(s.stddev / (n - 1)) : 0;
+    return s;
+}
+
+// Median time of the result called `name`, 0 when it was not run. Works for any result
+// type with a name and a summarized time.
+template <typename Result>
+double median_of(const std::vector<Result>& results, const std::string& name) {
+    for (const auto& r : results)
+        if (r.name == name)
+            return r.time.median;
+    return 0.0;
+}
+
+// Handed to every case body. The body does its own setup (allocation, initialization)
+// and then passes the part that should be timed to measure().
+class state {
+public:
+    explicit state(int repetitions, int threads = 1)
+        : repetitions_(repetitions), threads_(threads) {}
+
+    // One untimed warm-up call, then one timed call per repetition, on the timer backend
+    // selected with --timer. Kernels that return a value have it kept alive through a
+    // volatile sink.
+    template <typename Kernel>
+    void measure(Kernel&& kernel) {
+        constexpr bool returns_void = std::is_void_v<decltype(kernel())>;
+        if constexpr (returns_void)
+            kernel();
+        else
+            keep(kernel());
+
+        bench::timer timer;
+        for (int r = 0; r < repetitions_; r++) {
+            if constexpr (returns_void) {
+                timer.start();
+                kernel();
+                timer.stop();
+            } else {
+                timer.start();
+                auto result = kernel();
+                timer.stop();
+                keep(result);
+            }
+            samples_.push_back(double(timer.duration<bench::timer::nsec>().count()) / 1000.0);
+            cycle_samples_.push_back(timer.cycles());
+        }
+    }
+
+    // For cases that have to time themselves (work in other processes, for example):
+    // appends one repetition, in microseconds.
+    void record(double microseconds) { samples_.push_back(microseconds); }
+    // The same from a bench::timer the case started and stopped itself, cycles included.
+    void record(const bench::timer& timer) {
+        samples_.push_back(double(timer.duration<bench::timer::nsec>().count()) / 1000.0);
+        cycle_samples_.push_back(timer.cycles());
+    }
+
+    // Elements touched by one timed call, used for the ns/element column.
+    void set_elements(size_t n) { elements_ = n; }
+    // Bytes the kernel has to move per timed call (loads plus stores), used for GB/s.
+    void set_bytes(size_t n) { bytes_ = n; }
+    // Footprint of the data the kernel walks, used to pick the cache level it is compared with.
+    void set_working_set(size_t n) { working_set_ = n; }
+
+    // Extra per-case figures printed under the case row, in the order they were added.
+    void add_counter(std::string name, double value) { counters_.emplace_back(std::move(name), value); }
+    void add_note(std::string note) { notes_.push_back(std::move(note)); }
+
+    template <typename T>
+    void keep(const T& value) { sink_ = size_t(value); }
+
+    int                        repetitions() const { return repetitions_; }
+    int                        threads()     const { return threads_; }
+    size_t                     elements()    const { return elements_; }
+    size_t                     bytes()       const { return bytes_; }
+    size_t                     working_set() const { return working_set_; }
+    const std::vector<double>& samples()     const { return samples_; }
+    // TSC cycles per repetition of measure() or record(timer); empty for cases that
+    // record() plain microseconds.
+    const std::vector<double>& cycle_samples() const { return cycle_samples_; }
+    const std::vector<std::pair<std::string, double>>& counters() const { return counters_; }
+    const std::vector<std::string>&                    notes()    const { return notes_; }
+
+private:
+    int                 repetitions_;
+    int                 threads_;
+    size_t              elements_ = 0;
+    size_t              bytes_    = 0;
+    size_t              working_set_ = 0;
+    std::vector<double> samples_; // microseconds
+    std::vector<double> cycle_samples_;
+    std::vector<std::pair<std::string, double>> counters_;
+    std::vector<std::string>                    notes_;
+    volatile size_t     sink_     = 0;
+};
+
+struct bench_case {
+    std::string                 name; // kernel/order/layout/rows x cols
+    std::function<void(state&)> body;
+    int                         repetitions = 0; // 0 takes --reps from the command line
+    int                         threads     = 0; // 0 takes --threads from the command line
+    // Called once for every case selected to run, before the first one runs, so cases
+    // can claim shared resources for the runs that will actually happen.
+    std::function<void()>       on_select;
+};
+
+class registry {
+public:
+    void add(std::string name, std::function<void(state&)> body, int repetitions = 0, int threads = 0,
+             std::function<void()> on_select = {}) {
+        cases_.push_back({std::move(name), std::move(body), repetitions, threads, std::move(on_select)});
+    }
+
+    // Cases whose name matches any of the filters (searched, not anchored).
+    // No filters selects everything.
+    std::vector<const bench_case*> match(const std::vector<std::string>& filters) const {
+        std::vector<std::regex> patterns;
+        for (const auto& f : filters)
+            patterns.emplace_back(f);
+
+        std::vector<const bench_case*> selected;
+        for (const auto& c : cases_) {
+            bool hit = patterns.empty();
+            for (const auto& p : patterns)
+                hit = hit || std::regex_search(c.name, p);
+            if (hit)
+                selected.push_back(&c);
+        }
+        return selected;
+    }
+
+    const std::vector<bench_case>& cases() const { return cases_; }
+
+private:
+    std::vector<bench_case> cases_;
+};
+
+} // namespace bench
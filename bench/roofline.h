@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cache_info.h"
+#include "matrix.h"
+
+namespace bench {
+
+// Best read bandwidth the host reached on a working set of a given size.
+struct bandwidth_roof {
+    std::string name;        // L1, L2, ..., DRAM
+    size_t      capacity;    // largest working set this roof applies to; 0 for DRAM
+    size_t      working_set; // bytes actually read to measure it
+    double      gb_per_sec;
+};
+
+struct roofline {
+    std::vector<bandwidth_roof> roofs; // innermost first, DRAM last
+
+    // The roof of the innermost level that can hold `working_set` bytes.
+    const bandwidth_roof* matching(size_t working_set) const {
+        if (working_set == 0)
+            return nullptr;
+        for (const auto& r : roofs)
+            if (r.capacity == 0 || working_set <= r.capacity)
+                return &r;
+        return nullptr;
+    }
+
+    // Achieved bandwidth as a percentage of the matching roof, 0 when there is none.
+    double percent_of_roof(double gb_per_sec, size_t working_set) const {
+        const bandwidth_roof* r = matching(working_set);
+        return r && r->gb_per_sec ? gb_per_sec * 100.0 / r->gb_per_sec : 0;
+    }
+};
+
+// Contiguous read with four independent accumulators, the friendliest pattern the
+// hardware sees; this is what every traversal is compared against.
+inline size_t peak_read_sum(const int* data, size_t n) {
+    size_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i  = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += data[i];
+        s1 += data[i + 1];
+        s2 += data[i + 2];
+        s3 += data[i + 3];
+    }
+    for (; i < n; i++)
+        s0 += data[i];
+    return s0 + s1 + s2 + s3;
+}
+
+// Best of repeated passes over `bytes`, stopping after at least three passes and
+// about 50 ms, so the small levels get enough passes to warm up and the DRAM level
+// does not dominate startup.
+inline double measure_read_bandwidth(size_t bytes) {
+    size_t n    = std::max<size_t>(1, bytes / sizeof(int));
+    int*   data = static_cast<int*>(allocate_aligned(n * sizeof(int)));
+    for (size_t i = 0; i < n; i++)
+        data[i] = int(i);
+
+    volatile size_t sink = peak_read_sum(data, n);
+    double best_ns = 0, total_ns = 0;
+    for (int pass = 0; pass < 3 || total_ns < 50e6; pass++) {
+        auto start = std::chrono::steady_clock::now();
+        sink = peak_read_sum(data, n);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best_ns   = pass == 0 ? ns : std::min(best_ns, ns);
+        total_ns += ns;
+        if (pass >= 1000)
+            break;
+    }
+    (void)sink;
+
+    free_aligned(data);
+    return best_ns ? n * sizeof(int) / best_ns : 0;
+}
+
+// One roof per data cache level, measured on half the level, and one for DRAM measured
+// on dram_working_set bytes. Without room for that there is no DRAM roof, and working
+// sets beyond the last level match no roof rather than a cache one.
+inline roofline measure_roofline(const cache_topology& topo) {
+    roofline r;
+    for (const auto& c : topo.data_levels()) {
+        size_t ws = c.size / 2;
+        r.roofs.push_back({"L" + std::to_string(c.level), c.size, ws, measure_read_bandwidth(ws)});
+    }
+    if (size_t dram = dram_working_set(topo))
+        r.roofs.push_back({"DRAM", 0, dram, measure_read_bandwidth(dram)});
+    return r;
+}
+
+inline void print_roofline(const roofline& r) {
+    std::cout << "Peak read bandwidth:" << std::endl;
+    for (const auto& roof : r.roofs)
+        std::cout << "    " << std::left << std::setw(6) << roof.name
+                  << std::right << std::setw(12) << size_string(roof.working_set)
+                  << std::setw(10) << std::fixed << std::setprecision(2) << roof.gb_per_sec << " GB/s" << std::endl;
+    if (r.roofs.empty() || r.roofs.back().name != "DRAM")
+        std::cout << "    DRAM  not measured: a quarter of physical memory is under twice the last-level cache" << std::endl;
+}
+
+} // namespace bench
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "../kaizen.h"
+#include "cases.h"
+#include "kernels.h"
+#include "matrix.h"
+#include "parallel.h"
+#include "registry.h"
+
+namespace bench {
+
+// One line of a scenario file. Every option but the sizes, threads and repetitions may
+// list several values; the line expands to every combination of them.
+//
+//   --row_size 1024 --col_size 4096 --type int double --layout flat jagged
+//       --kernel read write rmw --order row column --threads 4 --reps 10
+//
+// --col_size defaults to --row_size, as in main; threads and repetitions default to
+// the command line.
+struct scenario {
+    int                      rows = 0;
+    int                      cols = 0;
+    std::vector<std::string> types   = {"int"};
+    std::vector<std::string> layouts = {"flat"};
+    std::vector<std::string> kernels = {"read"};
+    std::vector<std::string> orders  = {"row", "column"};
+    int                      threads     = 0;
+    int                      repetitions = 0;
+};
+
+namespace internal {
+
+    inline void check_values(const std::vector<std::string>& values, const std::vector<std::string>& allowed,
+                             const std::string& option, int line) {
+        for (const auto& v : values)
+            if (std::find(allowed.begin(), allowed.end(), v) == allowed.end())
+                throw std::invalid_argument("line " + std::to_string(line) + ": unknown " + option + " " + zen::quote(v));
+    }
+
+    inline int positive_option(const zen::cmd_args& args, const std::string& option, int fallback, int line) {
+        auto values = args.get_options(option);
+        if (values.empty())
+            return fallback;
+        int value = std::atoi(values[0].c_str());
+        if (value <= 0)
+            throw std::invalid_argument("line " + std::to_string(line) + ": " + option + " must be greater than 0");
+        return value;
+    }
+
+} // namespace internal
+
+// Throws std::runtime_error when the file cannot be opened and std::invalid_argument
+// on a malformed line.
+inline std::vector<scenario> load_scenarios(const std::filesystem::path& path) {
+    zen::file in(path);
+
+    std::vector<scenario> scenarios;
+    int line_number = 0;
+    for (const auto& line : in) {
+        line_number++;
+        zen::cmd_args args = zen::cmd_args::from_line(line);
+        if (args.count() == 0)
+            continue;
+
+        scenario s;
+        s.rows = internal::positive_option(args, "--row_size", 0, line_number);
+        s.cols = internal::positive_option(args, "--col_size", s.rows, line_number);
+        if (!s.rows)
+            throw std::invalid_argument("line " + std::to_string(line_number) + ": --row_size is required");
+        s.threads     = internal::positive_option(args, "--threads", 0, line_number);
+        s.repetitions = internal::positive_option(args, "--reps", 0, line_number);
+
+        if (args.is_present("--type"))   s.types   = args.get_options("--type");
+        if (args.is_present("--layout")) s.layouts = args.get_options("--layout");
+        if (args.is_present("--kernel")) s.kernels = args.get_options("--kernel");
+        if (args.is_present("--order"))  s.orders  = args.get_options("--order");
+
+        internal::check_values(s.types,   {"int", "int64", "float", "double"}, "--type",   line_number);
+        internal::check_values(s.layouts, {"flat", "jagged"},                  "--layout", line_number);
+        internal::check_values(s.kernels, {"read", "write", "rmw"},            "--kernel", line_number);
+        internal::check_values(s.orders,  {"row", "column"},                   "--order",  line_number);
+        scenarios.push_back(s);
+    }
+    return scenarios;
+}
+
+// Keeps matrices alive between runs of the same element type, layout and shape, so a
+// scenario file pays for each allocation and first touch once. Each case reserves its
+// matrix when it is selected to run, so a matrix is released after the last run that
+// needs it, whatever --filter left out.
+class matrix_pool {
+public:
+    using key = std::tuple<std::string, std::string, int, int>; // type, layout, rows, cols
+
+    void reserve(const key& k) { uses_[k]++; }
+
+    template <typename Matrix>
+    std::shared_ptr<Matrix> acquire(const key& k) {
+        auto& slot = matrices_[k];
+        if (!slot)
+            slot = std::make_shared<Matrix>(std::get<2>(k), std::get<3>(k));
+        return std::static_pointer_cast<Matrix>(slot);
+    }
+
+    void release(const key& k) {
+        if (--uses_[k] <= 0)
+            matrices_.erase(k);
+    }
+
+private:
+    std::map<key, std::shared_ptr<void>> matrices_;
+    std::map<key, int>                   uses_;
+};
+
+// Splits the outer loop of the traversal across threads: bands of rows in row order,
+// bands of columns in column order.
+template <typename Matrix>
+auto parallel_traversal_sum(const Matrix& m, bool row_order, int threads,
+                            std::vector<thread_timing>* timings = nullptr) {
+    using acc = accumulator_t<typename Matrix::value_type>;
+    acc        total = 0;
+    std::mutex lock;
+    parallel_for(threads, row_order ? m.rows : m.cols, [&](int first, int last) {
+        acc sum = 0;
+        if (row_order) {
+            for (int i = first; i < last; i++)
+                for (int j = 0; j < m.cols; j++)
+                    sum += m.at(i, j);
+        } else {
+            for (int j = first; j < last; j++)
+                for (int i = 0; i < m.rows; i++)
+                    sum += m.at(i, j);
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        total += sum;
+    }, timings, size_t(row_order ? m.cols : m.rows) * sizeof(typename Matrix::value_type));
+    return total;
+}
+
+template <typename Matrix>
+void parallel_traversal_update(Matrix& m, bool row_order, bool read_modify_write, int threads,
+                               std::vector<thread_timing>* timings = nullptr) {
+    parallel_for(threads, row_order ? m.rows : m.cols, [&](int first, int last) {
+        auto store = [&](int i, int j) {
+            if (read_modify_write)
+                m.at(i, j) += 1;
+            else
+                m.at(i, j) = typename Matrix::value_type(i + j);
+        };
+        if (row_order) {
+            for (int i = first; i < last; i++)
+                for (int j = 0; j < m.cols; j++)
+                    store(i, j);
+        } else {
+            for (int j = first; j < last; j++)
+                for (int i = 0; i < m.rows; i++)
+                    store(i, j);
+        }
+    }, timings, size_t(row_order ? m.cols : m.rows) * (read_modify_write ? 2 : 1) * sizeof(typename Matrix::value_type));
+}
+
+template <typename T, template <typename> class Layout>
+void add_scenario_case(registry& reg, const std::shared_ptr<matrix_pool>& pool, const scenario& s,
+                       const std::string& type, const std::string& layout, const std::string& kernel,
+                       const std::string& order) {
+    using Matrix = Layout<T>;
+    matrix_pool::key k{type, layout, s.rows, s.cols};
+
+    std::string name = kernel + "/" + order + "/" + layout + "/" + size_name(s.rows, s.cols) + "/" + type;
+    if (s.threads)
+        name += "/t" + std::to_string(s.threads);
+    bool   row_order = order == "row";
+    size_t bytes_per_element = (kernel == "rmw" ? 2 : 1) * sizeof(T);
+
+    reg.add(name, [=](state& st) {
+        std::shared_ptr<Matrix> m = pool->acquire<Matrix>(k);
+        std::vector<thread_timing> timings;
+        st.set_elements(m->size());
+        st.set_bytes(m->size() * bytes_per_element);
+        st.set_working_set(m->size() * sizeof(T));
+        if (kernel == "read")
+            st.measure([&] { return parallel_traversal_sum(*m, row_order, st.threads(), &timings); });
+        else
+            st.measure([&] { parallel_traversal_update(*m, row_order, kernel == "rmw", st.threads(), &timings); });
+        add_thread_counters(st, timings);
+        pool->release(k);
+    }, s.repetitions, s.threads, [pool, k] { pool->reserve(k); });
+}
+
+template <typename T>
+void add_scenario_cases(registry& reg, const std::shared_ptr<matrix_pool>& pool, const scenario& s,
+                        const std::string& type) {
+    for (const auto& layout : s.layouts)
+        for (const auto& kernel : s.kernels)
+            for (const auto& order : s.orders) {
+                if (layout == "flat")
+                    add_scenario_case<T, flat_matrix>(reg, pool, s, type, layout, kernel, order);
+                else
+                    add_scenario_case<T, jagged_matrix>(reg, pool, s, type, layout, kernel, order);
+            }
+}
+
+// Expands every scenario into registered cases that share one matrix_pool.
+inline void register_scenario_cases(registry& reg, const std::vector<scenario>& scenarios) {
+    auto pool = std::make_shared<matrix_pool>();
+    for (const auto& s : scenarios)
+        for (const auto& type : s.types) {
+            if (type == "int")    add_scenario_cases<int>(reg, pool, s, type);
+            if (type == "int64")  add_scenario_cases<long long>(reg, pool, s, type);
+            if (type == "float")  add_scenario_cases<float>(reg, pool, s, type);
+            if (type == "double") add_scenario_cases<double>(reg, pool, s, type);
+        }
+}
+
+} // namespace bench
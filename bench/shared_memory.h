@@ -0,0 +1,182 @@
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define BENCH_HAS_SHARED_MEMORY 1
+#else
+    #define BENCH_HAS_SHARED_MEMORY 0
+#endif
+
+#if BENCH_HAS_SHARED_MEMORY
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "thread_timing.h"
+
+namespace bench {
+
+// What one reader process leaves behind for the parent.
+struct reader_result {
+    double start_ns = 0; // steady clock, comparable across processes on the same host
+    double end_ns   = 0;
+    double sum      = 0;
+    int    cpu      = -1; // CPU the reader finished on
+};
+
+// Control block at the start of the segment. Lock-free atomics are address-free, so
+// they work from every process that maps the segment.
+struct shared_header {
+    std::atomic<int> arrived{0};
+    std::atomic<int> generation{0};
+    std::atomic<bool> aborted{false}; // set when not every reader could be started
+    int              readers = 0;
+    int              rows    = 0;
+    int              cols    = 0;
+};
+
+// A row-major int matrix in a POSIX shared-memory segment (shm_open + mmap), followed
+// by the control block and one result slot per reader. The name is unlinked as soon
+// as the segment is mapped, so nothing is left behind in /dev/shm if the run dies;
+// forked readers inherit the mapping.
+class shared_matrix {
+public:
+    static constexpr size_t max_readers = 256;
+
+    shared_matrix(int row_size, int col_size) {
+        header_bytes_ = align_up(sizeof(shared_header) + max_readers * sizeof(reader_result), 4096);
+        bytes_        = header_bytes_ + align_up(size_t(row_size) * col_size * sizeof(int), 4096);
+
+        std::string name = "/row_vs_column_" + std::to_string(getpid());
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            throw std::runtime_error("shm_open failed for " + name);
+        shm_unlink(name.c_str());
+        if (ftruncate(fd, off_t(bytes_)) != 0) {
+            close(fd);
+            throw std::runtime_error("ftruncate failed for " + name);
+        }
+        base_ = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base_ == MAP_FAILED)
+            throw std::runtime_error("mmap failed for " + name);
+
+        header_       = new (base_) shared_header();
+        header_->rows = row_size;
+        header_->cols = col_size;
+        for (int i = 0; i < row_size; i++)
+            for (int j = 0; j < col_size; j++)
+                at(i, j) = i + j;
+    }
+    ~shared_matrix() {
+        header_->~shared_header();
+        munmap(base_, bytes_);
+    }
+
+    shared_matrix(const shared_matrix&) = delete;
+    shared_matrix& operator=(const shared_matrix&) = delete;
+
+    int  rows() const { return header_->rows; }
+    int  cols() const { return header_->cols; }
+    int& at(int i, int j) { return data()[size_t(i) * header_->cols + j]; }
+
+    reader_result& result(int reader) {
+        return reinterpret_cast<reader_result*>(reinterpret_cast<char*>(base_) + sizeof(shared_header))[reader];
+    }
+
+    // Sense-reversing barrier across the reader processes. Returns false, without waiting
+    // for the others, once the parent has given up on the run.
+    bool arrive_and_wait() {
+        int gen = header_->generation.load(std::memory_order_acquire);
+        if (header_->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == header_->readers) {
+            header_->arrived.store(0, std::memory_order_relaxed);
+            header_->generation.fetch_add(1, std::memory_order_acq_rel);
+        } else {
+            while (header_->generation.load(std::memory_order_acquire) == gen) {
+                if (header_->aborted.load(std::memory_order_acquire))
+                    return false;
+                std::this_thread::yield();
+            }
+        }
+        return !header_->aborted.load(std::memory_order_acquire);
+    }
+
+    // Forks one process per entry of row_order; each waits at the barrier, walks the
+    // whole matrix in its order and writes its timestamps to its result slot.
+    // Returns false if a reader could not be started or did not exit cleanly. When a fork
+    // fails, the readers already started are released from the barrier and reaped.
+    bool run_readers(const std::vector<bool>& row_order) {
+        int readers = int(std::min(row_order.size(), max_readers));
+        header_->readers = readers;
+        header_->arrived.store(0);
+        header_->aborted.store(false);
+
+        std::vector<pid_t> children;
+        for (int r = 0; r < readers; r++) {
+            pid_t pid = fork();
+            if (pid == 0)
+                _exit(read_in_child(r, row_order[r]));
+            if (pid < 0)
+                break;
+            children.push_back(pid);
+        }
+
+        bool ok = int(children.size()) == readers;
+        if (!ok)
+            header_->aborted.store(true, std::memory_order_release);
+        for (pid_t pid : children) {
+            int status = 0;
+            waitpid(pid, &status, 0);
+            ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        }
+        return ok;
+    }
+
+private:
+    static size_t align_up(size_t n, size_t a) { return (n + a - 1) / a * a; }
+
+    int* data() { return reinterpret_cast<int*>(reinterpret_cast<char*>(base_) + header_bytes_); }
+
+    static double now_ns() {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int read_in_child(int reader, bool row_order) {
+        if (!arrive_and_wait())
+            return 1;
+        reader_result& out = result(reader);
+        out.start_ns = now_ns();
+        size_t sum = 0;
+        if (row_order) {
+            for (int i = 0; i < rows(); i++)
+                for (int j = 0; j < cols(); j++)
+                    sum += at(i, j);
+        } else {
+            for (int j = 0; j < cols(); j++)
+                for (int i = 0; i < rows(); i++)
+                    sum += at(i, j);
+        }
+        out.end_ns = now_ns();
+        out.sum    = double(sum);
+        out.cpu    = current_cpu();
+        return 0;
+    }
+
+    void*          base_         = nullptr;
+    shared_header* header_       = nullptr;
+    size_t         bytes_        = 0;
+    size_t         header_bytes_ = 0;
+};
+
+} // namespace bench
+
+#endif // BENCH_HAS_SHARED_MEMORY
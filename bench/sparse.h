@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "../kaizen.h"
+
+namespace bench {
+
+// Nonzeros as (row, column, value) triples sorted by row, then column. by_column
+// holds the same entries' indices sorted by column, then row, so a column-order
+// walk gathers through it instead of re-sorting the triples.
+struct coo_matrix {
+    using value_type = int;
+
+    int                   rows = 0;
+    int                   cols = 0;
+    std::vector<int>      row;
+    std::vector<int>      col;
+    std::vector<int>      values;
+    std::vector<uint32_t> by_column;
+
+    size_t nonzeros() const { return values.size(); }
+};
+
+// Compressed sparse row: the nonzeros of row i are [row_ptr[i], row_ptr[i + 1]).
+struct csr_matrix {
+    using value_type = int;
+
+    int              rows = 0;
+    int              cols = 0;
+    std::vector<int> row_ptr;
+    std::vector<int> col_idx;
+    std::vector<int> values;
+
+    size_t nonzeros() const { return values.size(); }
+};
+
+// Compressed sparse column: the nonzeros of column j are [col_ptr[j], col_ptr[j + 1]).
+struct csc_matrix {
+    using value_type = int;
+
+    int              rows = 0;
+    int              cols = 0;
+    std::vector<int> col_ptr;
+    std::vector<int> row_idx;
+    std::vector<int> values;
+
+    size_t nonzeros() const { return values.size(); }
+};
+
+// Keeps each element of `m` with probability `density` (0..1], drawn with
+// zen::random_int, so every run sees a different pattern of the same density.
+template <typename Matrix>
+coo_matrix sparsify(const Matrix& m, double density) {
+    constexpr int scale = 1000000;
+    int threshold = int(density * scale);
+
+    coo_matrix s;
+    s.rows = m.rows;
+    s.cols = m.cols;
+    for (int i = 0; i < m.rows; i++)
+        for (int j = 0; j < m.cols; j++)
+            if (zen::random_int(0, scale) < threshold) {
+                s.row.push_back(i);
+                s.col.push_back(j);
+                s.values.push_back(int(m.at(i, j)));
+            }
+
+    s.by_column.resize(s.nonzeros());
+    std::iota(s.by_column.begin(), s.by_column.end(), 0u);
+    std::stable_sort(s.by_column.begin(), s.by_column.end(),
+                     [&](uint32_t a, uint32_t b) { return s.col[a] < s.col[b]; });
+    return s;
+}
+
+inline csr_matrix to_csr(const coo_matrix& s) {
+    csr_matrix m;
+    m.rows = s.rows;
+    m.cols = s.cols;
+    m.row_ptr.assign(size_t(s.rows) + 1, 0);
+    for (int r : s.row)
+        m.row_ptr[r + 1]++;
+    std::partial_sum(m.row_ptr.begin(), m.row_ptr.end(), m.row_ptr.begin());
+    m.col_idx = s.col; // already in row order
+    m.values  = s.values;
+    return m;
+}
+
+inline csc_matrix to_csc(const coo_matrix& s) {
+    csc_matrix m;
+    m.rows = s.rows;
+    m.cols = s.cols;
+    m.col_ptr.assign(size_t(s.cols) + 1, 0);
+    for (int c : s.col)
+        m.col_ptr[c + 1]++;
+    std::partial_sum(m.col_ptr.begin(), m.col_ptr.end(), m.col_ptr.begin());
+    for (uint32_t k : s.by_column) {
+        m.row_idx.push_back(s.row[k]);
+        m.values.push_back(s.values[k]);
+    }
+    return m;
+}
+
+// Traversals visit every nonzero once and return their sum. The native order of each
+// format is a straight scan; the other order is what the format costs when the access
+// pattern does not match it.
+
+inline size_t row_major_sum(const csr_matrix& m) {
+    size_t sum = 0;
+    for (int i = 0; i < m.rows; i++)
+        for (int k = m.row_ptr[i]; k < m.row_ptr[i + 1]; k++)
+            sum += m.values[k];
+    return sum;
+}
+
+// Column j of a CSR matrix: every row keeps a cursor to its next unvisited nonzero,
+// so each column step checks the cursor of every row.
+inline size_t column_major_sum(const csr_matrix& m) {
+    std::vector<int> cursor(m.row_ptr.begin(), m.row_ptr.end() - 1);
+    size_t sum = 0;
+    for (int j = 0; j < m.cols; j++)
+        for (int i = 0; i < m.rows; i++) {
+            int k = cursor[i];
+            if (k < m.row_ptr[i + 1] && m.col_idx[k] == j) {
+                sum += m.values[k];
+                cursor[i] = k + 1;
+            }
+        }
+    return sum;
+}
+
+inline size_t column_major_sum(const csc_matrix& m) {
+    size_t sum = 0;
+    for (int j = 0; j < m.cols; j++)
+        for (int k = m.col_ptr[j]; k < m.col_ptr[j + 1]; k++)
+            sum += m.values[k];
+    return sum;
+}
+
+// Mirror image of column_major_sum(csr_matrix): one cursor per column.
+inline size_t row_major_sum(const csc_matrix& m) {
+    std::vector<int> cursor(m.col_ptr.begin(), m.col_ptr.end() - 1);
+    size_t sum = 0;
+    for (int i = 0; i < m.rows; i++)
+        for (int j = 0; j < m.cols; j++) {
+            int k = cursor[j];
+            if (k < m.col_ptr[j + 1] && m.row_idx[k] == i) {
+                sum += m.values[k];
+                cursor[j] = k + 1;
+            }
+        }
+    return sum;
+}
+
+inline size_t row_major_sum(const coo_matrix& m) {
+    size_t sum = 0;
+    for (size_t k = 0; k < m.nonzeros(); k++)
+        sum += m.values[k];
+    return sum;
+}
+
+// Column order through the by_column permutation: a gather from the row-sorted values.
+inline size_t column_major_sum(const coo_matrix& m) {
+    size_t sum = 0;
+    for (uint32_t k : m.by_column)
+        sum += m.values[k];
+    return sum;
+}
+
+// Bytes a traversal loads. A native-order scan reads the values and the per-row (or
+// per-column) pointers but never the index array. A mismatched order reads a cursor
+// and an end pointer at every step, the index under the cursor until its row (column)
+// runs out, and each value once.
+
+namespace internal {
+    // Index loads of a mismatched walk: line i is checked at every step up to and
+    // including the position of its last nonzero.
+    inline size_t cursor_index_loads(const std::vector<int>& ptr, const std::vector<int>& idx) {
+        size_t loads = 0;
+        for (size_t i = 0; i + 1 < ptr.size(); i++)
+            if (ptr[i + 1] > ptr[i])
+                loads += size_t(idx[ptr[i + 1] - 1]) + 1;
+        return loads;
+    }
+} // namespace internal
+
+inline size_t traversal_bytes(const csr_matrix& m, bool row_order) {
+    size_t values = m.nonzeros() * sizeof(int);
+    return row_order ? values + m.row_ptr.size() * sizeof(int)
+                     : values + (size_t(m.cols) * m.rows * 2 + internal::cursor_index_loads(m.row_ptr, m.col_idx)) * sizeof(int);
+}
+
+inline size_t traversal_bytes(const csc_matrix& m, bool row_order) {
+    size_t values = m.nonzeros() * sizeof(int);
+    return row_order ? values + (size_t(m.cols) * m.rows * 2 + internal::cursor_index_loads(m.col_ptr, m.row_idx)) * sizeof(int)
+                     : values + m.col_ptr.size() * sizeof(int);
+}
+
+inline size_t traversal_bytes(const coo_matrix& m, bool row_order) {
+    return m.nonzeros() * (row_order ? sizeof(int) : sizeof(int) + sizeof(uint32_t));
+}
+
+inline size_t storage_bytes(const csr_matrix& m) {
+    return (m.row_ptr.size() + m.col_idx.size() + m.values.size()) * sizeof(int);
+}
+
+inline size_t storage_bytes(const csc_matrix& m) {
+    return (m.col_ptr.size() + m.row_idx.size() + m.values.size()) * sizeof(int);
+}
+
+inline size_t storage_bytes(const coo_matrix& m) {
+    return (m.row.size() + m.col.size() + m.values.size()) * sizeof(int) + m.by_column.size() * sizeof(uint32_t);
+}
+
+} // namespace bench
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <vector>
+#include "kernels.h"
+#include "matrix.h"
+#include "parallel.h"
+
+#if __has_include(<execution>)
+    #include <execution>
+#endif
+#if defined(__cpp_lib_execution)
+    #define BENCH_HAS_STD_EXECUTION 1
+#else
+    #define BENCH_HAS_STD_EXECUTION 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define BENCH_HAS_SSE2 1
+#else
+    #define BENCH_HAS_SSE2 0
+#endif
+
+namespace bench {
+
+// What std::execution::par_unseq actually runs on. libstdc++ hands it to TBB when the
+// TBB headers are found (CMake links TBB or forces the serial backend); without
+// <execution> the std-par kernels call the policy-free overloads.
+inline const char* std_parallel_backend() {
+#if !BENCH_HAS_STD_EXECUTION
+    return "none (sequential fallback)";
+#elif defined(_PSTL_PAR_BACKEND_TBB)
+    return "tbb";
+#elif defined(_PSTL_PAR_BACKEND_SERIAL)
+    return "serial";
+#else
+    return "library default";
+#endif
+}
+
+// 0, 1, ..., count - 1: the index range the standard algorithms iterate over. Built
+// once per case, outside the timed calls.
+inline std::vector<int> index_range(int count) {
+    std::vector<int> indices(count);
+    std::iota(indices.begin(), indices.end(), 0);
+    return indices;
+}
+
+// Row and column sums written the way application code writes them: one
+// transform_reduce over row (or column) indices under a policy, each index mapped to
+// the sum of its row (or column).
+
+inline size_t row_sum_at(const flat_matrix<int>& m, int i) {
+    const int* row = &m.at(i, 0);
+    size_t     sum = 0;
+    for (int j = 0; j < m.cols; j++)
+        sum += row[j];
+    return sum;
+}
+
+inline size_t column_sum_at(const flat_matrix<int>& m, int j) {
+    size_t sum = 0;
+    for (int i = 0; i < m.rows; i++)
+        sum += m.at(i, j);
+    return sum;
+}
+
+#if BENCH_HAS_STD_EXECUTION
+    #define BENCH_TRANSFORM_REDUCE(policy, ...) std::transform_reduce(policy, __VA_ARGS__)
+#else
+    #define BENCH_TRANSFORM_REDUCE(policy, ...) std::transform_reduce(__VA_ARGS__)
+#endif
+
+inline size_t std_par_row_sum(const flat_matrix<int>& m, const std::vector<int>& rows) {
+    return BENCH_TRANSFORM_REDUCE(std::execution::par_unseq, rows.begin(), rows.end(), size_t(0), std::plus<>(),
+                                  [&m](int i) { return row_sum_at(m, i); });
+}
+
+inline size_t std_par_column_sum(const flat_matrix<int>& m, const std::vector<int>& cols) {
+    return BENCH_TRANSFORM_REDUCE(std::execution::par_unseq, cols.begin(), cols.end(), size_t(0), std::plus<>(),
+                                  [&m](int j) { return column_sum_at(m, j); });
+}
+
+// The same calls under std::execution::seq: the cost of the algorithm and the lambda
+// without any parallelism.
+
+inline size_t std_seq_row_sum(const flat_matrix<int>& m, const std::vector<int>& rows) {
+    return BENCH_TRANSFORM_REDUCE(std::execution::seq, rows.begin(), rows.end(), size_t(0), std::plus<>(),
+                                  [&m](int i) { return row_sum_at(m, i); });
+}
+
+inline size_t std_seq_column_sum(const flat_matrix<int>& m, const std::vector<int>& cols) {
+    return BENCH_TRANSFORM_REDUCE(std::execution::seq, cols.begin(), cols.end(), size_t(0), std::plus<>(),
+                                  [&m](int j) { return column_sum_at(m, j); });
+}
+
+#undef BENCH_TRANSFORM_REDUCE
+
+// Hand-written counterparts: SSE2 over a band of rows (or columns), the bands spread
+// over threads with parallel_for. Lanes are widened to 64 bits before they are added,
+// so the sums match size_t accumulation exactly.
+
+namespace internal {
+
+#if BENCH_HAS_SSE2
+    // Adds the four ints of v to the two 64-bit lanes of acc.
+    inline __m128i add_widened(__m128i acc, __m128i v) {
+        __m128i sign = _mm_srai_epi32(v, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign));
+        return _mm_add_epi64(acc, _mm_unpackhi_epi32(v, sign));
+    }
+
+    inline size_t horizontal_sum(__m128i acc) {
+        alignas(16) uint64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        return size_t(lanes[0] + lanes[1]);
+    }
+#endif
+
+} // namespace internal
+
+// Rows [first, last), each row four ints at a time.
+inline size_t simd_row_sum(const flat_matrix<int>& m, int first, int last) {
+    size_t sum = 0;
+    for (int i = first; i < last; i++) {
+        const int* row = &m.at(i, 0);
+        int        j   = 0;
+#if BENCH_HAS_SSE2
+        __m128i acc = _mm_setzero_si128();
+        for (; j + 4 <= m.cols; j += 4)
+            acc = internal::add_widened(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + j)));
+        sum += internal::horizontal_sum(acc);
+#endif
+        for (; j < m.cols; j++)
+            sum += row[j];
+    }
+    return sum;
+}
+
+// Columns [first, last) in strips of four: each strip is walked down the rows with one
+// vector load per row, the column-order access pattern with four lanes per load.
+inline size_t simd_column_sum(const flat_matrix<int>& m, int first, int last) {
+    size_t sum = 0;
+    int    j   = first;
+#if BENCH_HAS_SSE2
+    for (; j + 4 <= last; j += 4) {
+        __m128i acc = _mm_setzero_si128();
+        for (int i = 0; i < m.rows; i++)
+            acc = internal::add_widened(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m.at(i, j))));
+        sum += internal::horizontal_sum(acc);
+    }
+#endif
+    for (; j < last; j++)
+        for (int i = 0; i < m.rows; i++)
+            sum += m.at(i, j);
+    return sum;
+}
+
+inline size_t threaded_simd_row_sum(const flat_matrix<int>& m, int threads,
+                                    std::vector<thread_timing>* timings = nullptr) {
+    std::vector<size_t> partial(m.rows, 0);
+    parallel_for(threads, m.rows, [&](int first, int last) { partial[first] = simd_row_sum(m, first, last); },
+                 timings, size_t(m.cols) * sizeof(int));
+    return std::accumulate(partial.begin(), partial.end(), size_t(0));
+}
+
+inline size_t threaded_simd_column_sum(const flat_matrix<int>& m, int threads,
+                                       std::vector<thread_timing>* timings = nullptr) {
+    std::vector<size_t> partial(m.cols, 0);
+    parallel_for(threads, m.cols, [&](int first, int last) { partial[first] = simd_column_sum(m, first, last); },
+                 timings, size_t(m.rows) * sizeof(int));
+    return std::accumulate(partial.begin(), partial.end(), size_t(0));
+}
+
+} // namespace bench
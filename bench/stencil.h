@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include "matrix.h"
+
+namespace bench {
+
+// Jacobi-style stencils on flat_matrix<float>: every interior cell of `out` becomes the
+// average of its neighbourhood in `in`. The boundary rows and columns stay fixed, so
+// they are never written.
+enum class stencil_shape { five_point, nine_point };
+
+inline const char* stencil_name(stencil_shape s) {
+    return s == stencil_shape::five_point ? "stencil5" : "stencil9";
+}
+
+template <stencil_shape S, typename Matrix>
+float stencil_at(const Matrix& in, int i, int j) {
+    if constexpr (S == stencil_shape::five_point) {
+        return 0.2f * (in.at(i, j) + in.at(i - 1, j) + in.at(i + 1, j) + in.at(i, j - 1) + in.at(i, j + 1));
+    } else {
+        float sum = 0;
+        for (int di = -1; di <= 1; di++)
+            sum += in.at(i + di, j - 1) + in.at(i + di, j) + in.at(i + di, j + 1);
+        return sum * (1.0f / 9.0f);
+    }
+}
+
+template <stencil_shape S>
+void stencil_row_major(const flat_matrix<float>& in, flat_matrix<float>& out) {
+    for (int i = 1; i < in.rows - 1; i++)
+        for (int j = 1; j < in.cols - 1; j++)
+            out.at(i, j) = stencil_at<S>(in, i, j);
+}
+
+template <stencil_shape S>
+void stencil_column_major(const flat_matrix<float>& in, flat_matrix<float>& out) {
+    for (int j = 1; j < in.cols - 1; j++)
+        for (int i = 1; i < in.rows - 1; i++)
+            out.at(i, j) = stencil_at<S>(in, i, j);
+}
+
+// Row order within square tiles, so the three input rows a tile reads stay in cache
+// even when a whole matrix row does not fit.
+template <stencil_shape S>
+void stencil_tiled(const flat_matrix<float>& in, flat_matrix<float>& out, int tile) {
+    for (int ii = 1; ii < in.rows - 1; ii += tile)
+        for (int jj = 1; jj < in.cols - 1; jj += tile) {
+            int i_end = std::min(ii + tile, in.rows - 1);
+            int j_end = std::min(jj + tile, in.cols - 1);
+            for (int i = ii; i < i_end; i++)
+                for (int j = jj; j < j_end; j++)
+                    out.at(i, j) = stencil_at<S>(in, i, j);
+        }
+}
+
+// `steps` sweeps, ping-ponging between in and out: the untiled multi-step reference.
+// The result ends up in `out`; `in` is overwritten when steps > 1.
+template <stencil_shape S>
+void stencil_steps(flat_matrix<float>& in, flat_matrix<float>& out, int steps) {
+    flat_matrix<float>* src = &in;
+    flat_matrix<float>* dst = &out;
+    for (int t = 0; t < steps; t++) {
+        stencil_row_major<S>(*src, *dst);
+        std::swap(src, dst);
+    }
+    if (src != &out)
+        for (int i = 1; i < in.rows - 1; i++)
+            std::copy(&src->at(i, 1), &src->at(i, in.cols - 1), &out.at(i, 1));
+}
+
+// Temporal blocking with overlapped bands: a band of `band` rows plus `steps` halo rows
+// on each side is copied into a small buffer and advanced `steps` sweeps there, each
+// sweep giving up one halo row per side, before the band is written back. Every band
+// is read and written once for all `steps` sweeps, at the price of recomputing the
+// halo. The result equals stencil_steps.
+template <stencil_shape S>
+void stencil_temporal(const flat_matrix<float>& in, flat_matrix<float>& out, int steps, int band) {
+    int rows = in.rows, cols = in.cols;
+    flat_matrix<float> a(std::min(rows, band + 2 * steps), cols), b(std::min(rows, band + 2 * steps), cols);
+
+    for (int b0 = 1; b0 < rows - 1; b0 += band) {
+        int b1 = std::min(b0 + band, rows - 1);
+        int lo = std::max(0, b0 - steps), hi = std::min(rows, b1 + steps);
+        for (int g = lo; g < hi; g++) {
+            std::copy(&in.at(g, 0), &in.at(g, 0) + cols, &a.at(g - lo, 0));
+            std::copy(&in.at(g, 0), &in.at(g, 0) + cols, &b.at(g - lo, 0));
+        }
+
+        flat_matrix<float>* src = &a;
+        flat_matrix<float>* dst = &b;
+        for (int t = 0; t < steps; t++) {
+            int first = std::max(1, lo + t + 1), last = std::min(rows - 1, hi - t - 1);
+            for (int g = first; g < last; g++)
+                for (int j = 1; j < cols - 1; j++)
+                    dst->at(g - lo, j) = stencil_at<S>(*src, g - lo, j);
+            std::swap(src, dst);
+        }
+        for (int g = b0; g < b1; g++)
+            std::copy(&src->at(g - lo, 1), &src->at(g - lo, cols - 1), &out.at(g, 1));
+    }
+}
+
+} // namespace bench
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "matrix.h"
+#include "parallel.h"
+
+namespace bench {
+
+// The four STREAM kernels (McCalpin), applied element-wise to whole matrices:
+//   copy:  c = a
+//   scale: b = s * c
+//   add:   c = a + b
+//   triad: a = b + s * c
+enum class stream_op { copy, scale, add, triad };
+
+inline std::string stream_op_name(stream_op op) {
+    switch (op) {
+        case stream_op::copy:  return "copy";
+        case stream_op::scale: return "scale";
+        case stream_op::add:   return "add";
+        case stream_op::triad: return "triad";
+    }
+    return "";
+}
+
+// STREAM counts one read or one write per array element touched and ignores the
+// write-allocate traffic, so copy and scale move two words per element, add and triad three.
+inline size_t stream_words_per_element(stream_op op) {
+    return op == stream_op::copy || op == stream_op::scale ? 2 : 3;
+}
+
+template <typename T>
+struct stream_arrays {
+    flat_matrix<T> a, b, c;
+    T              scalar = T(3);
+
+    stream_arrays(int row_size, int col_size)
+        : a(row_size, col_size), b(row_size, col_size), c(row_size, col_size) {}
+};
+
+template <stream_op Op, typename T>
+inline void stream_element(stream_arrays<T>& s, int i, int j) {
+    if constexpr (Op == stream_op::copy)
+        s.c.at(i, j) = s.a.at(i, j);
+    else if constexpr (Op == stream_op::scale)
+        s.b.at(i, j) = s.scalar * s.c.at(i, j);
+    else if constexpr (Op == stream_op::add)
+        s.c.at(i, j) = s.a.at(i, j) + s.b.at(i, j);
+    else
+        s.a.at(i, j) = s.b.at(i, j) + s.scalar * s.c.at(i, j);
+}
+
+// Row order hands each thread a band of rows, column order a band of columns,
+// so both orders keep every thread on its own elements.
+template <stream_op Op, typename T>
+void stream_row_major(stream_arrays<T>& s, int threads, std::vector<thread_timing>* timings = nullptr) {
+    parallel_for(threads, s.a.rows, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+            for (int j = 0; j < s.a.cols; j++)
+                stream_element<Op>(s, i, j);
+    }, timings, size_t(s.a.cols) * stream_words_per_element(Op) * sizeof(T));
+}
+
+template <stream_op Op, typename T>
+void stream_column_major(stream_arrays<T>& s, int threads, std::vector<thread_timing>* timings = nullptr) {
+    parallel_for(threads, s.a.cols, [&](int first, int last) {
+        for (int j = first; j < last; j++)
+            for (int i = 0; i < s.a.rows; i++)
+                stream_element<Op>(s, i, j);
+    }, timings, size_t(s.a.rows) * stream_words_per_element(Op) * sizeof(T));
+}
+
+} // namespace bench
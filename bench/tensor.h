@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "kernels.h"
+#include "matrix.h"
+
+namespace bench {
+
+// Strides of an N-d tensor, in elements. Named after the std::mdspan layouts:
+// layout_right is C order (last axis contiguous), layout_left is Fortran order.
+
+template <size_t N>
+std::array<size_t, N> layout_right(const std::array<int, N>& extents) {
+    std::array<size_t, N> strides{};
+    size_t stride = 1;
+    for (size_t a = N; a-- > 0;) {
+        strides[a] = stride;
+        stride *= extents[a];
+    }
+    return strides;
+}
+
+template <size_t N>
+std::array<size_t, N> layout_left(const std::array<int, N>& extents) {
+    std::array<size_t, N> strides{};
+    size_t stride = 1;
+    for (size_t a = 0; a < N; a++) {
+        strides[a] = stride;
+        stride *= extents[a];
+    }
+    return strides;
+}
+
+// An arbitrary layout_stride example: axes stored in `storage_order` (slowest first),
+// with each contiguous run padded to whole cache lines of T.
+template <typename T, size_t N>
+std::array<size_t, N> layout_stride(const std::array<int, N>& extents, const std::array<int, N>& storage_order,
+                                    size_t line_size = 64) {
+    std::array<size_t, N> strides{};
+    size_t stride = 1;
+    for (size_t k = N; k-- > 0;) {
+        int axis = storage_order[k];
+        strides[axis] = stride;
+        stride *= k == N - 1 ? line_padded_ld<T>(extents[axis], line_size) : extents[axis];
+    }
+    return strides;
+}
+
+// N-d tensor over one aligned allocation. Element (i0, ..., iN-1) is at
+// sum(ia * strides[a]) and holds the sum of its indices, the N-d form of i + j.
+template <typename T, size_t N>
+struct tensor {
+    using value_type = T;
+    using index_type = std::array<int, N>;
+
+    std::array<int, N>    extents;
+    std::array<size_t, N> strides;
+    size_t                span; // elements from the first to one past the last
+    T*                    data;
+
+    tensor(const std::array<int, N>& ext, const std::array<size_t, N>& str)
+        : extents(ext), strides(str), span(1) {
+        for (size_t a = 0; a < N; a++)
+            span += size_t(extents[a] - 1) * strides[a];
+        data = static_cast<T*>(allocate_aligned(span * sizeof(T)));
+        std::fill(data, data + span, T(0));
+        index_type idx{};
+        fill(0, 0, idx);
+    }
+    ~tensor() { free_aligned(data); }
+
+    tensor(const tensor&) = delete;
+    tensor& operator=(const tensor&) = delete;
+
+    T& at(const index_type& idx) { return data[offset(idx)]; }
+    const T& at(const index_type& idx) const { return data[offset(idx)]; }
+
+    size_t offset(const index_type& idx) const {
+        size_t off = 0;
+        for (size_t a = 0; a < N; a++)
+            off += size_t(idx[a]) * strides[a];
+        return off;
+    }
+
+    size_t size() const {
+        size_t n = 1;
+        for (int e : extents)
+            n *= e;
+        return n;
+    }
+
+private:
+    void fill(size_t axis, size_t off, index_type& idx) {
+        for (idx[axis] = 0; idx[axis] < extents[axis]; idx[axis]++) {
+            size_t o = off + size_t(idx[axis]) * strides[axis];
+            if (axis + 1 == N)
+                data[o] = T(std::accumulate(idx.begin(), idx.end(), 0));
+            else
+                fill(axis + 1, o, idx);
+        }
+    }
+};
+
+namespace internal {
+
+    template <typename T, size_t N, typename Sum>
+    void tensor_sum_level(const tensor<T, N>& t, const std::array<int, N>& order, size_t depth, size_t off, Sum& sum) {
+        int    axis   = order[depth];
+        size_t stride = t.strides[axis];
+        int    n      = t.extents[axis];
+        if (depth + 1 == N) {
+            const T* p = t.data + off;
+            for (int k = 0; k < n; k++)
+                sum += p[size_t(k) * stride];
+        } else {
+            for (int k = 0; k < n; k++)
+                tensor_sum_level(t, order, depth + 1, off + size_t(k) * stride, sum);
+        }
+    }
+
+} // namespace internal
+
+// Sum of every element with the loops nested in `order`: order[0] is the outermost
+// axis, order[N - 1] the innermost. The 2D row and column traversals are {0, 1} and
+// {1, 0} on a layout_right tensor.
+template <typename T, size_t N>
+auto tensor_sum(const tensor<T, N>& t, const std::array<int, N>& order) {
+    accumulator_t<T> sum = 0;
+    internal::tensor_sum_level(t, order, 0, 0, sum);
+    return sum;
+}
+
+// Every loop order over N axes, in lexicographic order.
+template <size_t N>
+std::vector<std::array<int, N>> loop_orders() {
+    std::array<int, N> order;
+    std::iota(order.begin(), order.end(), 0);
+    std::vector<std::array<int, N>> orders;
+    do
+        orders.push_back(order);
+    while (std::next_permutation(order.begin(), order.end()));
+    return orders;
+}
+
+// "0123": axes from outermost to innermost loop.
+template <size_t N>
+std::string loop_order_name(const std::array<int, N>& order) {
+    std::string name;
+    for (int axis : order)
+        name += char('0' + axis);
+    return name;
+}
+
+} // namespace bench
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
+namespace bench {
+
+// What one thread of a parallel kernel did during one call. Times are from the moment
+// the call started, so a late start shows up next to a slow share.
+struct thread_timing {
+    double start_ns = 0;
+    double end_ns   = 0;
+    double busy_ns  = 0;  // time on its share; less than end - start when it also waited
+    size_t bytes    = 0;  // bytes the program asked it to move
+    int    cpu      = -1; // CPU it finished on, -1 when unknown
+};
+
+using thread_clock = std::chrono::steady_clock;
+
+inline int current_cpu() {
+#if defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+// Closes a share that started at `start`, with the call's clock starting at `origin`.
+inline void record_thread(thread_timing& t, thread_clock::time_point origin, thread_clock::time_point start,
+                          size_t bytes) {
+    auto end  = thread_clock::now();
+    auto ns   = [](thread_clock::duration d) { return std::chrono::duration<double, std::nano>(d).count(); };
+    t.start_ns = ns(start - origin);
+    t.end_ns   = ns(end - origin);
+    t.busy_ns  = ns(end - start);
+    t.bytes    = bytes;
+    t.cpu      = current_cpu();
+}
+
+// NUMA node of a CPU from the cpu<N>/node<M> link in sysfs, -1 when unknown.
+inline int numa_node_of_cpu(int cpu) {
+    if (cpu < 0)
+        return -1;
+    std::error_code ec;
+    std::filesystem::path dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.rfind("node", 0) == 0 && name.size() > 4 && std::isdigit(static_cast<unsigned char>(name[4])))
+            return std::stoi(name.substr(4));
+    }
+    return -1;
+}
+
+// The slowest thread by busy time and how far the team was from an even split.
+struct thread_summary {
+    double max_min_ratio = 0; // slowest busy time over fastest
+    double imbalance     = 0; // slowest over mean, minus one: 0 is a perfect split
+    int    slowest       = -1;
+    int    cpu           = -1;
+    int    node          = -1;
+};
+
+// Works for thread_timing and anything derived from it.
+template <typename Timing>
+thread_summary summarize_threads(const std::vector<Timing>& threads) {
+    thread_summary s;
+    if (threads.empty())
+        return s;
+    double min_ns = threads[0].busy_ns, max_ns = 0, total_ns = 0;
+    for (size_t t = 0; t < threads.size(); t++) {
+        min_ns    = std::min(min_ns, threads[t].busy_ns);
+        total_ns += threads[t].busy_ns;
+        if (s.slowest < 0 || threads[t].busy_ns > max_ns) {
+            max_ns    = threads[t].busy_ns;
+            s.slowest = int(t);
+        }
+    }
+    s.max_min_ratio = min_ns ? max_ns / min_ns : 0;
+    s.imbalance     = total_ns ? max_ns * threads.size() / total_ns - 1.0 : 0;
+    s.cpu           = threads[s.slowest].cpu;
+    s.node          = numa_node_of_cpu(s.cpu);
+    return s;
+}
+
+} // namespace bench
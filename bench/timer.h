@@ -0,0 +1,183 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "cache_info.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+    #define BENCH_HAS_RDTSC 1
+#else
+    #define BENCH_HAS_RDTSC 0
+#endif
+
+// Configure with -DMATRIX_BENCH_TSC_TIMER=ON to make the TSC the default backend.
+#ifndef BENCH_TIMER_TSC
+    #define BENCH_TIMER_TSC 0
+#endif
+
+namespace bench {
+
+// A timestamp cheap enough to take around every row of a traversal: the time-stamp
+// counter on x86, steady_clock ticks elsewhere. Not serialized; see tsc_begin/tsc_end.
+inline uint64_t cycle_count() {
+#if BENCH_HAS_RDTSC
+    return __rdtsc();
+#else
+    return uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Nanoseconds per cycle_count() tick. The TSC rate is measured once against
+// steady_clock over 20 ms, the first time it is needed.
+inline double ns_per_tick() {
+    static const double ratio = [] {
+        using clock = std::chrono::steady_clock;
+#if BENCH_HAS_RDTSC
+        auto     t0 = clock::now();
+        uint64_t c0 = cycle_count();
+        while (clock::now() - t0 < std::chrono::milliseconds(20)) {
+        }
+        auto     t1 = clock::now();
+        uint64_t c1 = cycle_count();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / double(c1 - c0);
+#else
+        return 1e9 * clock::period::num / clock::period::den;
+#endif
+    }();
+    return ratio;
+}
+
+// CPUID 0x80000007 EDX bit 8: the TSC ticks at one rate through P-, C- and T-state
+// changes, so a single calibration factor turns ticks into time. The ticks are
+// reference cycles at that rate, not the core's current clock.
+inline bool invariant_tsc() {
+#if BENCH_HAS_RDTSC && BENCH_HAS_CPUID
+    unsigned regs[4] = {};
+    if (!internal::cpuid(0x80000000u, 0, regs) || regs[0] < 0x80000007u)
+        return false;
+    return internal::cpuid(0x80000007u, 0, regs) && (regs[3] & (1u << 8));
+#else
+    return false;
+#endif
+}
+
+#if BENCH_HAS_RDTSC
+// Serialized reads around a timed region. The fences keep earlier work from drifting
+// past the first read and later work from starting before the last one; rdtscp
+// itself waits for everything before it to finish.
+inline uint64_t tsc_begin() {
+    _mm_lfence();
+    uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+}
+
+inline uint64_t tsc_end() {
+    unsigned aux;
+    uint64_t t = __rdtscp(&aux);
+    _mm_lfence();
+    return t;
+}
+#endif
+
+// clock: high_resolution_clock, as zen::timer. tsc: serialized rdtsc/rdtscp.
+enum class timer_backend { clock, tsc };
+
+inline const char* timer_backend_name(timer_backend b) {
+    return b == timer_backend::tsc ? "tsc" : "clock";
+}
+
+inline bool parse_timer_backend(const std::string& name, timer_backend& b) {
+    if (name != "clock" && name != "tsc")
+        return false;
+    b = name == "tsc" ? timer_backend::tsc : timer_backend::clock;
+    return true;
+}
+
+namespace internal {
+    inline timer_backend& timer_backend_setting() {
+        static timer_backend backend = BENCH_TIMER_TSC && invariant_tsc() ? timer_backend::tsc : timer_backend::clock;
+        return backend;
+    }
+} // namespace internal
+
+inline timer_backend active_timer_backend() { return internal::timer_backend_setting(); }
+
+// Selects the backend for timers created afterwards. Returns false, keeping the clock,
+// when the TSC is missing or not invariant.
+inline bool set_timer_backend(timer_backend b) {
+    if (b == timer_backend::tsc && !invariant_tsc())
+        return false;
+    internal::timer_backend_setting() = b;
+    return true;
+}
+
+// zen::timer's interface over the backend active when the timer was created, plus
+// cycles(): TSC ticks with the tsc backend, the wall time converted at the calibrated
+// TSC rate with the clock backend (0 without a TSC).
+class timer {
+public:
+    using nsec = std::chrono::nanoseconds;
+    using usec = std::chrono::microseconds;
+    using msec = std::chrono::milliseconds;
+
+    timer() : backend_(active_timer_backend()) {
+        if (backend_ == timer_backend::tsc)
+            ns_per_tick(); // calibrate now, not inside the first timed region
+    }
+
+    timer& start() {
+#if BENCH_HAS_RDTSC
+        if (backend_ == timer_backend::tsc) {
+            start_tsc_ = tsc_begin();
+            return *this;
+        }
+#endif
+        start_ = clock::now();
+        return *this;
+    }
+
+    timer& stop() {
+#if BENCH_HAS_RDTSC
+        if (backend_ == timer_backend::tsc) {
+            stop_tsc_ = tsc_end();
+            return *this;
+        }
+#endif
+        stop_ = clock::now();
+        return *this;
+    }
+
+    template <class Duration>
+    Duration duration() const {
+        if (backend_ == timer_backend::tsc)
+            return std::chrono::duration_cast<Duration>(
+                std::chrono::duration<double, std::nano>(double(stop_tsc_ - start_tsc_) * ns_per_tick()));
+        return std::chrono::duration_cast<Duration>(stop_ - start_);
+    }
+
+    double cycles() const {
+        if (backend_ == timer_backend::tsc)
+            return double(stop_tsc_ - start_tsc_);
+        if (!BENCH_HAS_RDTSC)
+            return 0;
+        return std::chrono::duration<double, std::nano>(stop_ - start_).count() / ns_per_tick();
+    }
+
+    timer_backend backend() const { return backend_; }
+
+private:
+    using clock = std::chrono::high_resolution_clock;
+
+    timer_backend     backend_;
+    clock::time_point start_{}, stop_{};
+    uint64_t          start_tsc_ = 0, stop_tsc_ = 0;
+};
+
+} // namespace bench
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "matrix.h"
+#include "thread_timing.h"
+
+namespace bench {
+
+struct tile {
+    int row0, col0;
+    int rows, cols;
+};
+
+// Chase-Lev work-stealing deque (the C11 formulation by Le, Pop, Cohen and Zappa Nardelli).
+// The owner pushes and pops at the bottom, thieves take from the top with one CAS.
+// Capacity is fixed: every tile is pushed before the workers start, so the buffer
+// never grows and is never written while thieves read it.
+class tile_deque {
+public:
+    explicit tile_deque(size_t capacity) {
+        size_t n = 1;
+        while (n < capacity)
+            n <<= 1;
+        buffer_.resize(n);
+        mask_ = int64_t(n - 1);
+    }
+
+    void push(const tile& t) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        buffer_[b & mask_] = t;
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    bool pop(tile& out) {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = buffer_[b & mask_];
+        if (t == b) {
+            // Last tile: race the thieves for it
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    bool steal(tile& out) {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b)
+            return false;
+
+        out = buffer_[t & mask_];
+        return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                            std::memory_order_relaxed);
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::vector<tile>                buffer_;
+    int64_t                          mask_ = 0;
+};
+
+inline std::vector<tile> make_tiles(int row_size, int col_size, int tile_rows, int tile_cols) {
+    std::vector<tile> tiles;
+    for (int i = 0; i < row_size; i += tile_rows)
+        for (int j = 0; j < col_size; j += tile_cols)
+            tiles.push_back({i, j, std::min(tile_rows, row_size - i), std::min(tile_cols, col_size - j)});
+    return tiles;
+}
+
+template <typename Matrix>
+size_t tile_sum(const Matrix& m, const tile& t, bool row_order) {
+    size_t sum = 0;
+    if (row_order) {
+        for (int i = t.row0; i < t.row0 + t.rows; i++)
+            for (int j = t.col0; j < t.col0 + t.cols; j++)
+                sum += m.at(i, j);
+    } else {
+        for (int j = t.col0; j < t.col0 + t.cols; j++)
+            for (int i = t.row0; i < t.row0 + t.rows; i++)
+                sum += m.at(i, j);
+    }
+    return sum;
+}
+
+// What each worker did during one scheduled traversal: its thread_timing plus the
+// tiles it ran and how many of them it stole.
+struct worker_stats : thread_timing {
+    size_t tiles  = 0;
+    size_t steals = 0;
+};
+
+// Static partitioning: each thread takes one contiguous band of rows and walks it in
+// the requested order. Busy time is the whole band.
+template <typename Matrix>
+size_t static_row_band_sum(const Matrix& m, int threads, bool row_order, std::vector<worker_stats>& workers) {
+    threads = std::max(1, std::min(threads, m.rows));
+    workers.assign(threads, {});
+    std::vector<size_t> sums(threads, 0);
+    auto origin = thread_clock::now();
+
+    auto work = [&](int t) {
+        int  first = int(static_cast<long long>(m.rows) * t / threads);
+        int  last  = int(static_cast<long long>(m.rows) * (t + 1) / threads);
+        auto start = thread_clock::now();
+        sums[t] = tile_sum(m, {first, 0, last - first, m.cols}, row_order);
+        record_thread(workers[t], origin, start, size_t(last - first) * m.cols * sizeof(typename Matrix::value_type));
+        workers[t].tiles = 1;
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++)
+        pool.emplace_back(work, t);
+    work(0);
+    for (auto& p : pool)
+        p.join();
+
+    size_t sum = 0;
+    for (size_t s : sums)
+        sum += s;
+    return sum;
+}
+
+// Work stealing: tiles are dealt to the workers in contiguous blocks, as a static split
+// would, then idle workers steal from random victims until every tile is done.
+// Busy time counts only time spent inside tiles, not time spent looking for one; the
+// end time is when the worker saw no tiles left.
+template <typename Matrix>
+size_t work_stealing_sum(const Matrix& m, const std::vector<tile>& tiles, int threads, bool row_order,
+                         std::vector<worker_stats>& workers) {
+    threads = std::max(1, std::min<int>(threads, int(tiles.size())));
+    workers.assign(threads, {});
+
+    std::vector<std::unique_ptr<tile_deque>> deques;
+    for (int t = 0; t < threads; t++)
+        deques.push_back(std::make_unique<tile_deque>(tiles.size() / threads + 1));
+    for (int t = 0; t < threads; t++) {
+        size_t first = tiles.size() * t / threads;
+        size_t last  = tiles.size() * (t + 1) / threads;
+        // Pushed back to front so the owner pops its block in order
+        for (size_t k = last; k-- > first;)
+            deques[t]->push(tiles[k]);
+    }
+
+    std::atomic<size_t> remaining{tiles.size()};
+    std::vector<size_t> sums(threads, 0);
+    auto origin = thread_clock::now();
+
+    auto work = [&](int self) {
+        std::minstd_rand rng(self + 1);
+        worker_stats&    stats = workers[self];
+        size_t           sum   = 0;
+        double           busy  = 0;
+        size_t           bytes = 0;
+        tile             t;
+        auto             start = thread_clock::now();
+
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            bool got = deques[self]->pop(t);
+            if (!got && threads > 1) {
+                int victim = int(rng() % (threads - 1));
+                victim += victim >= self;
+                got = deques[victim]->steal(t);
+                stats.steals += got;
+            }
+            if (got) {
+                auto tile_start = thread_clock::now();
+                sum += tile_sum(m, t, row_order);
+                busy  += std::chrono::duration<double, std::nano>(thread_clock::now() - tile_start).count();
+                bytes += size_t(t.rows) * t.cols * sizeof(typename Matrix::value_type);
+                stats.tiles++;
+                remaining.fetch_sub(1, std::memory_order_release);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        sums[self] = sum;
+        record_thread(stats, origin, start, bytes);
+        stats.busy_ns = busy;
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++)
+        pool.emplace_back(work, t);
+    work(0);
+    for (auto& p : pool)
+        p.join();
+
+    size_t sum = 0;
+    for (size_t s : sums)
+        sum += s;
+    return sum;
+}
+
+} // namespace bench
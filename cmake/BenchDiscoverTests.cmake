@@ -0,0 +1,26 @@
+# Runs after the bench executable is built: asks it for its registered cases
+# and writes one CTest smoke test per case, each running a single repetition
+# without the startup bandwidth measurement.
+#
+# Expects BENCH_EXECUTABLE and CTEST_FILE to be set with -D.
+
+execute_process(
+    COMMAND "${BENCH_EXECUTABLE}" --list
+    OUTPUT_VARIABLE bench_cases
+    RESULT_VARIABLE bench_result
+)
+if(NOT bench_result EQUAL 0)
+    message(FATAL_ERROR "${BENCH_EXECUTABLE} --list failed with ${bench_result}")
+endif()
+
+string(REPLACE "\n" ";" bench_cases "${bench_cases}")
+set(content "")
+foreach(bench_case IN LISTS bench_cases)
+    if(bench_case STREQUAL "")
+        continue()
+    endif()
+    string(APPEND content
+        "add_test(\"bench:${bench_case}\" \"${BENCH_EXECUTABLE}\" --filter \"^${bench_case}$\" --reps 1 --no-roofs)\n")
+endforeach()
+
+file(WRITE "${CTEST_FILE}" "${content}")
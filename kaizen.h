@@ -474,12 +474,30 @@ private:
 // const bool verbose = cmd_args.accept("-verbose").is_present();
 // const bool ignore  = cmd_args.accept("-ignore" ).is_present();
 
+// Arguments can also come from somewhere other than main(), e.g. one line of a file:
+// zen::cmd_args line_args = zen::cmd_args::from_line("--size 10 --verbose # comment");
+
 // TODO: Enhance with support for:
 // - Help strings
+// - Quoted arguments in from_line()
 class cmd_args {
 public:
     cmd_args() : argv_(nullptr), argc_(0) {}
 
+    // Takes ownership of already split arguments; unlike argv, arg_at(0) is the first option
+    explicit cmd_args(std::vector<std::string> tokens)
+        : argv_(nullptr), argc_(static_cast<int>(tokens.size())), tokens_(std::move(tokens)) {}
+
+    // Splits a line on whitespace, ignoring everything from the first '#' on
+    static cmd_args from_line(const std::string& line)
+    {
+        std::istringstream in(line.substr(0, line.find('#')));
+        std::vector<std::string> tokens;
+        for (std::string token; in >> token; )
+            tokens.push_back(token);
+        return cmd_args(std::move(tokens));
+    }
+
     cmd_args(const char* const* argv, int argc)
         : argv_(argv), argc_(argc)
     {
@@ -547,10 +565,12 @@ public:
     std::string arg_at(const int n) const
     {
         if (0 <= n && n < argc_)
-            return argv_[n];
+            return argv_ ? std::string(argv_[n]) : tokens_[n];
         return ""; // signals non-existence
     }
 
+    std::size_t count() const { return static_cast<std::size_t>(argc_); }
+
     std::string first() const { return arg_at(0); }
     std::string  last() const { return arg_at(argc_ - 1); }
 
@@ -570,6 +590,7 @@ private:
 
     const char* const* argv_;
     const int          argc_;
+    arguments          tokens_; // owned arguments when not constructed from argv
     arguments          args_accepted_;
 };
 
@@ -1,9 +1,17 @@
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <cmath>
 #include <cstdlib>
 #include <malloc.h>
 #include <vector>
 #include "kaizen.h"
+#include "bench/cache_info.h"
+#include "bench/matrix.h"
+#include "bench/openmp.h"
+#include "bench/pipeline.h"
+#include "bench/roofline.h"
+#include "bench/timer.h"
 
 using namespace std;
 
@@ -25,7 +33,9 @@ void columnMajorAccess(int** matrix, int row_size, int col_size) {
     }
 }
 
-bool parse_input(zen::cmd_args &args, int &row_size, int &col_size) {
+// Several values make a sweep: the n-th --row_size pairs with the n-th --col_size,
+// and a row size without a matching column size is square.
+bool parse_input(zen::cmd_args &args, vector<pair<int, int>> &sizes) {
     auto row_options = args.get_options("--row_size");
     auto col_options = args.get_options("--col_size");
     
@@ -34,11 +44,31 @@ bool parse_input(zen::cmd_args &args, int &row_size, int &col_size) {
         return false;
     }
 
-    row_size = row_options.size() ? std::atoi(row_options[0].c_str()) : std::atoi(col_options[0].c_str());
-    col_size = col_options.size() ? std::atoi(col_options[0].c_str()) : row_size;
+    size_t count = std::max(row_options.size(), col_options.size());
+    for (size_t k = 0; k < count; k++) {
+        int row_size = k < row_options.size() ? std::atoi(row_options[k].c_str()) : std::atoi(col_options[k].c_str());
+        int col_size = k < col_options.size() ? std::atoi(col_options[k].c_str()) : row_size;
 
-    if (!row_size || !col_size) {
-        std::cout << "Error: Row and column values must be greater than 0.";
+        if (!row_size || !col_size) {
+            std::cout << "Error: Row and column values must be greater than 0.";
+            return false;
+        }
+        sizes.push_back({row_size, col_size});
+    }
+
+    auto timer_options = args.get_options("--timer");
+    bench::timer_backend backend = bench::active_timer_backend();
+    if (args.is_present("--timer") && (timer_options.empty() || !bench::parse_timer_backend(timer_options[0], backend))) {
+        std::cout << "Error: --timer expects clock or tsc.";
+        return false;
+    }
+    if (!bench::set_timer_backend(backend)) {
+        std::cout << "Error: --timer tsc needs an invariant time-stamp counter, which this CPU does not report.";
+        return false;
+    }
+
+    if (args.is_present("--openmp") && !BENCH_HAS_OPENMP) {
+        std::cout << "Error: --openmp needs a build configured with -DMATRIX_BENCH_OPENMP=ON.";
         return false;
     }
     return true;
@@ -68,13 +98,32 @@ int** initialize_matrix(int row_size, int col_size) {
     return matrix;
 }
 
-void output_results(auto duration_row, auto duration_col, auto row_size, auto col_size) {
-    double row_ms = duration_row;
-    double col_ms = duration_col;
-    double diff_ms = duration_col - duration_row;
+// One row and one column traversal of a matrix.
+struct traversal_times {
+    double row_ms;
+    double col_ms;
+    double row_cycles;
+    double col_cycles;
+};
+
+void output_results(const traversal_times& times, auto row_size, auto col_size, const bench::roofline& roofs) {
+    double row_ms = times.row_ms;
+    double col_ms = times.col_ms;
+    double diff_ms = col_ms - row_ms;
     double speedup = row_ms ? col_ms / row_ms : 0;
 
+    // Each traversal reads every element once
+    double elements = double(row_size) * col_size;
+    size_t bytes = size_t(row_size) * col_size * sizeof(int);
+    double row_gbs = row_ms ? bytes / (row_ms * 1e6) : 0;
+    double col_gbs = col_ms ? bytes / (col_ms * 1e6) : 0;
+    const bench::bandwidth_roof* roof = roofs.matching(bytes);
+
     cout << "Matrix Size: " << row_size << " x " << col_size << endl;
+    cout << "Bytes moved per traversal: " << bytes;
+    if (roof)
+        cout << " (compared with the " << roof->name << " roof, " << fixed << setprecision(2) << roof->gb_per_sec << " GB/s)";
+    cout << endl;
     cout << fixed << setprecision(2);
     cout << "-----------------------------------------------------------------" << endl;
     cout << left << setw(15) << "" 
@@ -89,23 +138,40 @@ void output_results(auto duration_row, auto duration_col, auto row_size, auto co
          << setw(12) << col_ms 
          << setw(12) << speedup 
          << setw(17) << diff_ms << endl;
+    cout << left << setw(15) << "GB/s" 
+         << right << setw(7) << row_gbs 
+         << setw(12) << col_gbs << endl;
+    cout << left << setw(15) << "Cycles/elem" 
+         << right << setw(7) << times.row_cycles / elements 
+         << setw(12) << times.col_cycles / elements << endl;
+    if (roof)
+        cout << left << setw(15) << "% of roof" 
+             << right << setw(7) << roofs.percent_of_roof(row_gbs, bytes) 
+             << setw(12) << roofs.percent_of_roof(col_gbs, bytes) << endl;
     cout << "-----------------------------------------------------------------" << endl << endl;
 }
 
-void test_matrix_efficiency(int **matrix, int row_size, int col_size) {
-    zen::timer timer;
+traversal_times time_traversals(int **matrix, int row_size, int col_size) {
+    bench::timer timer;
+    traversal_times times;
 
     timer.start();
     rowMajorAccess(matrix, row_size, col_size);
     timer.stop();
-    auto duration_row = timer.duration<zen::timer::msec>().count();
+    times.row_ms = timer.duration<bench::timer::nsec>().count() / 1e6;
+    times.row_cycles = timer.cycles();
     
     timer.start();
     columnMajorAccess(matrix, row_size, col_size);
     timer.stop();
-    auto duration_col = timer.duration<zen::timer::msec>().count();
+    times.col_ms = timer.duration<bench::timer::nsec>().count() / 1e6;
+    times.col_cycles = timer.cycles();
     
-    output_results(duration_row, duration_col, row_size, col_size);
+    return times;
+}
+
+void test_matrix_efficiency(int **matrix, int row_size, int col_size, const bench::roofline& roofs) {
+    output_results(time_traversals(matrix, row_size, col_size), row_size, col_size, roofs);
 }
 
 void delete_matrix(int **matrix, int row_size) {
@@ -115,43 +181,58 @@ void delete_matrix(int **matrix, int row_size) {
     delete[] matrix;
 }
 
+// One traversal of each order, averaged over the iterations of test_aligned_matrix.
+struct aligned_result {
+    double row_ns;
+    double col_ns;
+    double row_cycles;
+    double col_cycles;
+};
+
+// Rows are ld elements apart (ld >= col_size), so padding beyond col_size is skipped by both traversals.
 template <typename matrix_t>
-void test_aligned_matrix(matrix_t aligned_matrix, int row_size, int col_size, vector<pair<int, int>>& sizes, vector<pair<double, double>>& results) {
-    for (int i = 0; i < row_size * col_size; i++)
-        aligned_matrix[i] = i;
+void test_aligned_matrix(matrix_t aligned_matrix, int row_size, int col_size, int ld, vector<pair<int, int>>& sizes, vector<aligned_result>& results, int iterations = 1000) {
+    for (int i = 0; i < row_size; i++)
+        for (int j = 0; j < col_size; j++)
+            aligned_matrix[i * ld + j] = i * col_size + j;
     
-    zen::timer timer;
+    bench::timer timer;
     volatile int sum = 0;
     
     timer.start();
-    for (int k = 0; k < 1000; k++)
-        for (int i = 0; i < row_size * col_size; i++)
-            sum += aligned_matrix[i];
+    for (int k = 0; k < iterations; k++)
+        for (int i = 0; i < row_size; i++)
+            for (int j = 0; j < col_size; j++)
+                sum += aligned_matrix[i * ld + j];
     timer.stop();
-    auto duration_row = timer.duration<zen::timer::usec>().count();
+    double duration_row = double(timer.duration<bench::timer::nsec>().count()) / iterations;
+    double cycles_row = timer.cycles() / iterations;
     
     timer.start();
-    for (int k = 0; k < 1000; k++)
+    for (int k = 0; k < iterations; k++)
         for (int j = 0; j < col_size; ++j)
             for (int i = 0; i < row_size; ++i) 
-                sum += aligned_matrix[i * col_size + j];
+                sum += aligned_matrix[i * ld + j];
     timer.stop();
-    auto duration_col = timer.duration<zen::timer::usec>().count();
+    double duration_col = double(timer.duration<bench::timer::nsec>().count()) / iterations;
+    double cycles_col = timer.cycles() / iterations;
     
     sizes.push_back({row_size, col_size});
-    results.push_back({duration_row, duration_col});
+    results.push_back({duration_row, duration_col, cycles_row, cycles_col});
 }
 
-bool test_allocated_aligned_matrix(int row_size, int col_size, vector<pair<int, int>>& sizes, vector<pair<double, double>>& results) {
+bool test_allocated_aligned_matrix(int row_size, int col_size, int ld, vector<pair<int, int>>& sizes, vector<aligned_result>& results, int iterations = 1000) {
+    size_t line = bench::host_cache_topology().line_size;
+    size_t bytes = (row_size * ld * sizeof(int) + line - 1) / line * line;
     #ifdef _WIN32
-        alignas(64) int* aligned_matrix = static_cast<int*>(_aligned_malloc(row_size * col_size * sizeof(int), 64));
+        alignas(64) int* aligned_matrix = static_cast<int*>(_aligned_malloc(bytes, line));
     #else
-        alignas(64) int* aligned_matrix = static_cast<int*>(std::aligned_alloc(64, row_size * col_size * sizeof(int)));
+        alignas(64) int* aligned_matrix = static_cast<int*>(std::aligned_alloc(line, bytes));
     #endif
     if (!aligned_matrix)
         return false;
     
-    test_aligned_matrix(aligned_matrix, row_size, col_size, sizes, results);
+    test_aligned_matrix(aligned_matrix, row_size, col_size, ld, sizes, results, iterations);
     
     #ifdef _WIN32
         _aligned_free(aligned_matrix);
@@ -161,30 +242,35 @@ bool test_allocated_aligned_matrix(int row_size, int col_size, vector<pair<int,
     return true;
 }
 
-void test_static_aligned_matrix(int row_size, int col_size, vector<pair<int, int>>& sizes, vector<pair<double, double>>& results) {
+void test_static_aligned_matrix(int row_size, int col_size, vector<pair<int, int>>& sizes, vector<aligned_result>& results) {
     alignas(64) int arr[row_size * col_size];
-    test_aligned_matrix(arr, row_size, col_size, sizes, results);
+    test_aligned_matrix(arr, row_size, col_size, col_size, sizes, results);
 }
 
-void print_aligned_results(const vector<pair<int, int>>& sizes, const vector<pair<double, double>>& results) {
+void print_aligned_results(const vector<pair<int, int>>& sizes, const vector<aligned_result>& results) {
+    string ratio = sizes.size() > 1 ? to_string(sizes[1].first) + "x" + to_string(sizes[1].second) + "/"
+                                    + to_string(sizes[0].first) + "x" + to_string(sizes[0].second) : "";
     cout << fixed << setprecision(2);
-    cout << "--------------------------------------------------------------------------------------------------------" << endl;
+    cout << "-------------------------------------------------------------------------------------------------------------------------------------" << endl;
     cout << left << setw(20) << "Matrix Size" 
          << right << setw(9) << "Row (ns)" 
          << setw(13) << "Column (ns)" 
          << setw(13) << "Speedup (x)" 
          << setw(13) << "Difference" 
-         << setw(15) << "Row 4x5/4x4" 
-         << setw(15) << "Col 4x5/4x4" << endl;
-    cout << "--------------------------------------------------------------------------------------------------------" << endl;
+         << setw(15) << "Row " + ratio 
+         << setw(15) << "Col " + ratio
+         << setw(15) << "Row cyc/elem"
+         << setw(15) << "Col cyc/elem" << endl;
+    cout << "-------------------------------------------------------------------------------------------------------------------------------------" << endl;
 
     for (size_t i = 0; i < sizes.size(); i++) {
-        double row_ns = results[i].first;
-        double col_ns = results[i].second;
+        double row_ns = results[i].row_ns;
+        double col_ns = results[i].col_ns;
         double diff_ns = col_ns - row_ns;
         double speedup = row_ns ? col_ns / row_ns : 0;
-        double row_ratio = (i == 0) ? 0 : row_ns / results[0].first;
-        double col_ratio = (i == 0) ? 0 : col_ns / results[0].second;
+        double row_ratio = (i == 0) ? 0 : row_ns / results[0].row_ns;
+        double col_ratio = (i == 0) ? 0 : col_ns / results[0].col_ns;
+        double elements = double(sizes[i].first) * sizes[i].second;
         string size = to_string(sizes[i].first) + " x " + to_string(sizes[i].second);
 
         cout << left << setw(20) << size
@@ -193,39 +279,249 @@ void print_aligned_results(const vector<pair<int, int>>& sizes, const vector<pai
              << setw(12) << speedup 
              << setw(17) << diff_ns 
              << setw(15) << row_ratio 
-             << setw(15) << col_ratio << endl;
+             << setw(15) << col_ratio
+             << setw(15) << results[i].row_cycles / elements
+             << setw(15) << results[i].col_cycles / elements << endl;
     }
-    cout << "--------------------------------------------------------------------------------------------------------" << endl << endl;
+    cout << "-------------------------------------------------------------------------------------------------------------------------------------" << endl << endl;
+}
+
+// Every table below is timed with bench::timer, so one line covers them all.
+void print_timer_backend() {
+    cout << "Timer: " << bench::timer_backend_name(bench::active_timer_backend())
+         << (bench::active_timer_backend() == bench::timer_backend::tsc ? ", cycles are TSC reference cycles"
+                                                                          : ", cycles estimated from wall time") << endl << endl;
+}
+
+// Power-of-two row lengths map every element of a column to the same few cache sets;
+// padding the leading dimension spreads them out again.
+void test_ld_padding_sweep(int row_size, int col_size) {
+    vector<pair<int, int>> sizes;
+    vector<aligned_result> results;
+    vector<pair<string, int>> paddings = bench::ld_padding_sweep<int>(col_size, bench::host_cache_topology().line_size);
+
+    for (const auto& [label, ld] : paddings)
+        if (!test_allocated_aligned_matrix(row_size, col_size, ld, sizes, results, 1))
+            return;
+
+    cout << "Matrix Size: " << row_size << " x " << col_size << endl;
+    cout << fixed << setprecision(2);
+    cout << "--------------------------------------------------------------------------------" << endl;
+    cout << left << setw(20) << "Padding"
+         << right << setw(12) << "Leading dim"
+         << setw(12) << "Row (us)"
+         << setw(14) << "Column (us)"
+         << setw(22) << "Column vs unpadded" << endl;
+    cout << "--------------------------------------------------------------------------------" << endl;
+
+    for (size_t i = 0; i < paddings.size(); i++) {
+        double col_ratio = results[0].col_ns ? results[i].col_ns / results[0].col_ns : 0;
+
+        cout << left << setw(20) << paddings[i].first
+             << right << setw(12) << paddings[i].second
+             << setw(12) << results[i].row_ns / 1000.0
+             << setw(14) << results[i].col_ns / 1000.0
+             << setw(22) << col_ratio << endl;
+    }
+    cout << "--------------------------------------------------------------------------------" << endl << endl;
+}
+
+// Measures every size in turn while a background thread allocates and initializes the
+// next one; the measurement taken during that setup is the size's result. With `check`,
+// each size is measured once more after the setup, and the difference between the two
+// is reported as the disturbance the overlap caused.
+bool test_pipelined_sweep(const vector<pair<int, int>>& sizes, const bench::roofline& roofs, bool check) {
+    vector<traversal_times> overlapped(sizes.size()), quiet(sizes.size());
+    bool failed = false;
+
+    bench::pipeline_timing timing = bench::run_pipelined(int(sizes.size()),
+        [&](int i) { return initialize_matrix(sizes[i].first, sizes[i].second); },
+        [&](int i, int **matrix, bool during_setup) {
+            if (!matrix) {
+                failed = true;
+                return;
+            }
+            auto times = time_traversals(matrix, sizes[i].first, sizes[i].second);
+            // The last size has no setup to overlap with, so its only run is its result
+            bool result = during_setup || i + 1 == int(sizes.size());
+            (result ? overlapped[i] : quiet[i]) = times;
+            if (result)
+                output_results(times, sizes[i].first, sizes[i].second, roofs);
+        },
+        [&](int i, int **matrix) {
+            if (matrix)
+                delete_matrix(matrix, sizes[i].first);
+        }, check);
+    if (failed)
+        return false;
+
+    cout << "Pipelined sweep (" << (timing.isolated ? "measurement and setup on separate CPUs"
+                                                    : "one CPU available, setup shares it with measurement") << "):" << endl;
+    cout << fixed << setprecision(2);
+    if (check) {
+        cout << "------------------------------------------------------------------------------" << endl;
+        cout << left << setw(20) << "Matrix Size"
+             << right << setw(14) << "Row change %"
+             << setw(17) << "Column change %"
+             << setw(27) << "(during setup vs after)" << endl;
+        cout << "------------------------------------------------------------------------------" << endl;
+        for (size_t i = 0; i + 1 < sizes.size(); i++) {
+            auto change = [](double during, double after) { return after ? (during - after) * 100.0 / after : 0; };
+            double row_change = change(overlapped[i].row_ms, quiet[i].row_ms);
+            double col_change = change(overlapped[i].col_ms, quiet[i].col_ms);
+            cout << left << setw(20) << to_string(sizes[i].first) + " x " + to_string(sizes[i].second)
+                 << right << setw(14) << row_change
+                 << setw(17) << col_change
+                 << setw(27) << (std::max(std::abs(row_change), std::abs(col_change)) > 5 ? "disturbed" : "ok") << endl;
+        }
+        cout << "------------------------------------------------------------------------------" << endl;
+    }
+    cout << "CPU time in setup and teardown: " << timing.setup_ms << " ms, measurement: " << timing.measure_ms
+         << " ms, check runs: " << timing.check_ms << " ms, wall: " << timing.wall_ms
+         << " ms, saved: " << timing.saved_ms() << " ms ("
+         << (timing.setup_ms + timing.measure_ms ? timing.saved_ms() * 100.0 / (timing.setup_ms + timing.measure_ms) : 0)
+         << "% of a serial run)" << endl << endl;
+    return true;
+}
+
+// Every OpenMP schedule in omp_policy_sweep for the row, column and tiled traversals.
+// Overhead is the time lost against perfect scaling of the one-thread run; the loop
+// column is the same schedule over a generated matrix, i.e. scheduling and loop control
+// with no memory traffic. Each time is the best of three, with its cycles per element and
+// how evenly that run's threads shared the loop.
+void test_openmp_schedules(int row_size, int col_size, const bench::roofline& roofs) {
+    bench::jagged_matrix<int> matrix(row_size, col_size);
+    bench::generated_matrix<int> generated(row_size, col_size);
+    int threads = bench::omp_max_threads();
+    int tile = bench::l1_tile_side<int>(bench::host_cache_topology());
+    size_t bytes = matrix.size() * sizeof(int);
+    const bench::bandwidth_roof* roof = roofs.matching(bytes);
+
+    struct omp_run {
+        double ms;
+        double cycles_per_element;
+        bench::thread_summary threads;
+    };
+    auto best_run = [&](const auto& m, bench::omp_traversal order, const bench::omp_policy& policy, int team) {
+        omp_run best{};
+        vector<bench::thread_timing> timings;
+        for (int k = 0; k < 3; k++) {
+            bench::timer timer;
+            timer.start();
+            volatile size_t sum = bench::omp_sum(m, order, policy, team, tile, &timings);
+            timer.stop();
+            (void)sum;
+            double ms = timer.duration<bench::timer::nsec>().count() / 1e6;
+            if (!k || ms < best.ms)
+                best = {ms, timer.cycles() / double(m.size()), bench::summarize_threads(timings)};
+        }
+        return best;
+    };
+    auto best_ms = [&](const auto& m, bench::omp_traversal order, const bench::omp_policy& policy, int team) {
+        return best_run(m, order, policy, team).ms;
+    };
+
+    cout << "OpenMP schedules, matrix size " << row_size << " x " << col_size << ", " << threads << " threads, "
+         << tile << " x " << tile << " tiles";
+    if (roof)
+        cout << " (" << roof->name << " roof " << fixed << setprecision(2) << roof->gb_per_sec << " GB/s)";
+    cout << ":" << endl << fixed << setprecision(2);
+
+    for (auto order : {bench::omp_traversal::row, bench::omp_traversal::column, bench::omp_traversal::tiled}) {
+        double serial = best_ms(matrix, order, {bench::omp_schedule::static_, 0, false}, 1);
+        string best_policy;
+        double best_time = 0;
+
+        cout << bench::omp_traversal_name(order) << " traversal, 1 thread: " << serial << " ms" << endl;
+        cout << "------------------------------------------------------------------------------------------------------------------------------------------------" << endl;
+        cout << left << setw(28) << "Schedule"
+             << right << setw(12) << "Time (ms)"
+             << setw(10) << "GB/s"
+             << setw(12) << "Cyc/elem"
+             << setw(14) << "Speedup (x)"
+             << setw(14) << "Overhead %"
+             << setw(14) << "Loop (ms)"
+             << setw(10) << "Max/min"
+             << setw(10) << "Imbal %"
+             << setw(22) << "Slowest (cpu, node)" << endl;
+        cout << "------------------------------------------------------------------------------------------------------------------------------------------------" << endl;
+        for (const auto& policy : bench::omp_policy_sweep()) {
+            auto [ms, cycles, team] = best_run(matrix, order, policy, threads);
+            double loop_ms = best_ms(generated, order, policy, threads);
+            if (best_policy.empty() || ms < best_time) {
+                best_policy = policy.name();
+                best_time = ms;
+            }
+            cout << left << setw(28) << policy.name()
+                 << right << setw(12) << ms
+                 << setw(10) << (ms ? bytes / (ms * 1e6) : 0)
+                 << setw(12) << cycles
+                 << setw(14) << (ms ? serial / ms : 0)
+                 << setw(14) << (serial ? (ms * threads - serial) * 100.0 / serial : 0)
+                 << setw(14) << loop_ms
+                 << setw(10) << team.max_min_ratio
+                 << setw(10) << team.imbalance * 100.0
+                 << setw(22) << to_string(team.slowest) + " (" + to_string(team.cpu) + ", " + to_string(team.node) + ")" << endl;
+        }
+        cout << "------------------------------------------------------------------------------------------------------------------------------------------------" << endl;
+        cout << "Fastest " << bench::omp_traversal_name(order) << " schedule: " << best_policy << endl;
+    }
+    cout << endl;
 }
 
 int main(int argc, char **argv) {
     zen::cmd_args args(argv, argc);
-    int row_size, col_size;
-    int **matrix;
+    vector<pair<int, int>> sizes;
     
-    if (!parse_input(args, row_size, col_size))
+    if (!parse_input(args, sizes))
         return 1;
-    matrix = initialize_matrix(row_size, col_size);
-    if (!matrix)
-        return 2;
-    test_matrix_efficiency(matrix, row_size, col_size);
-    delete_matrix(matrix, row_size);
+
+    const bench::cache_topology& topo = bench::host_cache_topology();
+    auto [fits, straddles] = bench::line_straddle_shapes<int>(topo);
+    bench::roofline roofs = bench::measure_roofline(topo);
+
+    bench::print_cache_topology(topo);
+    bench::print_roofline(roofs);
+    print_timer_backend();
+    if (args.is_present("--pipeline") && sizes.size() > 1) {
+        if (!test_pipelined_sweep(sizes, roofs, args.is_present("--pipeline_check")))
+            return 2;
+    } else {
+        for (auto [row_size, col_size] : sizes) {
+            int **matrix = initialize_matrix(row_size, col_size);
+            if (!matrix)
+                return 2;
+            test_matrix_efficiency(matrix, row_size, col_size, roofs);
+            delete_matrix(matrix, row_size);
+        }
+    }
 
     std::cout << "Testing row-major vs column-major traversal performance with cache-aligned and unaligned matrices: "
-        << std::endl << "4x4 fits in one cache line, 4x5 spans two" << std::endl;
+        << std::endl << fits.first << "x" << fits.second << " fits in one cache line, "
+        << straddles.first << "x" << straddles.second << " spans two" << std::endl;
 
     vector<pair<int, int>> alloc_sizes, static_sizes;
-    vector<pair<double, double>> alloc_results, static_results;
+    vector<aligned_result> alloc_results, static_results;
 
     std::cout << "Testing allocated aligned matrix performance: " << std::endl;
-    test_allocated_aligned_matrix(4, 4, alloc_sizes, alloc_results);
-    test_allocated_aligned_matrix(4, 5, alloc_sizes, alloc_results);
+    test_allocated_aligned_matrix(fits.first, fits.second, fits.second, alloc_sizes, alloc_results);
+    test_allocated_aligned_matrix(straddles.first, straddles.second, straddles.second, alloc_sizes, alloc_results);
     print_aligned_results(alloc_sizes, alloc_results);
 
     std::cout << "Testing static aligned matrix performance: " << std::endl;
-    test_static_aligned_matrix(4, 4, static_sizes, static_results);
-    test_static_aligned_matrix(4, 5, static_sizes, static_results);
+    test_static_aligned_matrix(fits.first, fits.second, static_sizes, static_results);
+    test_static_aligned_matrix(straddles.first, straddles.second, static_sizes, static_results);
     print_aligned_results(static_sizes, static_results);
 
+    if (args.is_present("--openmp"))
+        for (auto [row_size, col_size] : sizes)
+            test_openmp_schedules(row_size, col_size, roofs);
+
+    if (args.is_present("--ld_sweep")) {
+        std::cout << "Testing column traversal with a padded leading dimension: " << std::endl;
+        for (auto [row_size, col_size] : sizes)
+            test_ld_padding_sweep(row_size, col_size);
+    }
+
     return 0;
 }
\ No newline at end of file